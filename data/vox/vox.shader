@@ -2,25 +2,43 @@
 #inout vec3 ioFragPos;
 #inout vec3 ioNormal;
 #inout vec2 ioUV;
+#inout vec2 ioTile;
 #inout float ioAo;
 
 /////////////////////////////////////////////////////////////////////////////////
 #vertex
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aUV;
-layout (location = 3) in float aAo;
+// Packed ChunkMesh::Vertex
+// aData0: x (5 bits), y (10 bits), z (5 bits), face (3 bits), ao (2 bits)
+// aData1: u (5 bits), v (5 bits), atlas tile index (16 bits)
+layout (location = 0) in uint aData0;
+layout (location = 1) in uint aData1;
 
 uniform mat4 uModelViewProj;
 
+uniform vec2 uAtlasTileSize;
+uniform int uAtlasTilesPerRow;
+
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3(1, 0, 0), vec3(-1, 0, 0),
+    vec3(0, 1, 0), vec3(0, -1, 0),
+    vec3(0, 0, 1), vec3(0, 0, -1)
+);
+
 void main()
 {
-    vec4 glob_pos = vec4(aPos, 1.0f);
-    gl_Position = uModelViewProj * glob_pos;
-    ioFragPos = aPos;
-    ioNormal = aNormal;
-    ioUV = aUV;
-    ioAo = aAo;
+    vec3 pos = vec3(float(aData0 & 31u), float((aData0 >> 5) & 1023u), float((aData0 >> 15) & 31u));
+    uint face = (aData0 >> 20) & 7u;
+    uint ao = (aData0 >> 23) & 3u;
+
+    vec2 uv = vec2(float(aData1 & 31u), float((aData1 >> 5) & 31u));
+    int tile = int(aData1 >> 10);
+
+    gl_Position = uModelViewProj * vec4(pos, 1.0f);
+    ioFragPos = pos;
+    ioNormal = FACE_NORMALS[face];
+    ioUV = uv;
+    ioTile = vec2(float(tile % uAtlasTilesPerRow), float(tile / uAtlasTilesPerRow)) * uAtlasTileSize;
+    ioAo = 1.0 - float(ao) / 3.0;
 }
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -36,12 +54,15 @@ uniform GlobalLight uSunLight;
 uniform vec3 uAmbientColor;
 
 uniform sampler2D atlas;
+uniform vec2 uAtlasTileSize;
 
 void main()
 {
     vec3 norm = normalize(ioNormal);
 
-    vec4 albedo_color = texture(atlas, ioUV);
+    // Merged faces repeat the tile, gradients are taken before fract() to keep the mip level
+    vec2 uv = ioTile + fract(ioUV) * uAtlasTileSize;
+    vec4 albedo_color = textureGrad(atlas, uv, dFdx(ioUV) * uAtlasTileSize, dFdy(ioUV) * uAtlasTileSize);
 
     vec4 ambient = vec4(albedo_color.xyz * uAmbientColor, albedo_color.w);
 
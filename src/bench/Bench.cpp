@@ -0,0 +1,78 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+    #include <Windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+double bench::get_ms(Clock::time_point begin, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+int bench::get_num_threads(const Settings &settings)
+{
+    return settings.threads > 0 ? settings.threads
+                                : std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void bench::run_parallel(int num_threads, int count, const std::function<void(int, int)> &fn)
+{
+    std::atomic<int> next{0};
+    const auto worker = [&](int thread_index) {
+        for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            fn(i, thread_index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+uint64_t bench::get_peak_memory_bytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    #ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+    #else
+    return (uint64_t)usage.ru_maxrss * 1024;
+    #endif
+#endif
+}
+
+double bench::get_percentile(const std::vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = (size_t)(percentile * (double)(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
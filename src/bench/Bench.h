@@ -0,0 +1,53 @@
+#pragma once
+
+#include "voxels/ChunkMeshGenerator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace bench
+{
+
+struct Settings
+{
+    const char *bench{"pipeline"};
+    // The meshed area is size x size chunks, the generated area has a border of one chunk more,
+    // so all the meshed chunks have the neighbours
+    int size{16};
+    unsigned int seed{123132};
+    int threads{0}; // 0 - all the cores
+    int cave_lattice_step{4};
+    ChunkMeshGenerator::Mode mode{ChunkMeshGenerator::Mode::Greedy};
+    const char *output{nullptr}; // stdout if null
+};
+
+using Clock = std::chrono::steady_clock;
+
+double get_ms(Clock::time_point begin, Clock::time_point end);
+
+// Settings threads or all the cores
+int get_num_threads(const Settings &settings);
+
+// Calls fn(index, thread_index) for [0, count) on the threads pulling the indices, the calling
+// thread is the thread 0
+void run_parallel(int num_threads, int count, const std::function<void(int, int)> &fn);
+
+uint64_t get_peak_memory_bytes();
+
+double get_percentile(const std::vector<double> &sorted, double percentile);
+
+// The benchmarks write the results as JSON to the out, the result is the exit code: non-zero if
+// a check of the benchmark failed
+int run_pipeline(const Settings &settings, FILE *out);
+int run_noise(const Settings &settings, FILE *out);
+int run_codec(const Settings &settings, FILE *out);
+int run_jobs(const Settings &settings, FILE *out);
+int run_chunks_map(const Settings &settings, FILE *out);
+int run_terrain(const Settings &settings, FILE *out);
+int run_profiler(const Settings &settings, FILE *out);
+int run_task_graph(const Settings &settings, FILE *out);
+
+} // namespace bench
@@ -0,0 +1,123 @@
+// Cost of the "Init new chunks" scan of VoxelEngine::update: every spawn offset is checked for
+// the chunks enqueued for generation. The ChunksMap slot states are compared with the linear
+// search over the enqueued positions they replaced
+
+#include "Bench.h"
+
+#include "utils/Algos.h"
+#include "voxels/ChunksMap.h"
+
+#include <glm/vec2.hpp>
+
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+
+// Same as in VoxelEngine
+constexpr int MULTIPLIER = 20;
+constexpr int RADIUS_SPAWN_CHUNK = 2 * MULTIPLIER;
+constexpr int RADIUS_UNLOAD_WHOLE_CHUNK = 4 * MULTIPLIER;
+
+constexpr int NUM_QUEUED_CHUNKS = 2500;
+constexpr int NUM_UPDATES = 200;
+
+// VoxelEngine::OffsetsCache::getOffsets(), the nearest offsets first
+std::vector<glm::ivec2> get_spawn_offsets(int radius)
+{
+    std::vector<glm::ivec2> offsets;
+    const int radius2 = radius * radius;
+    for (int z = -radius; z <= radius; ++z)
+    {
+        for (int x = -radius; x <= radius; ++x)
+        {
+            if (x * x + z * z <= radius2)
+            {
+                offsets.emplace_back(x, z);
+            }
+        }
+    }
+    Alg::sort(offsets, [](glm::ivec2 lhs, glm::ivec2 rhs) {
+        return lhs.x * lhs.x + lhs.y * lhs.y < rhs.x * rhs.x + rhs.y * rhs.y;
+    });
+    return offsets;
+}
+
+} // namespace
+
+int bench::run_chunks_map(const Settings &settings, FILE *out)
+{
+    (void)settings;
+
+    const std::vector<glm::ivec2> offsets = get_spawn_offsets(RADIUS_SPAWN_CHUNK);
+    const glm::ivec2 center{1000, -1000};
+
+    ChunksMap chunks_map;
+    chunks_map.setRadius(RADIUS_UNLOAD_WHOLE_CHUNK);
+    chunks_map.setCenter(center);
+
+    // The nearest chunks are enqueued first, as the update does
+    std::vector<glm::ivec2> queued;
+    for (int i = 0; i < NUM_QUEUED_CHUNKS; ++i)
+    {
+        const glm::ivec2 pos = center + offsets[i];
+        chunks_map.setChunkState(pos, ChunksMap::ChunkState::Queued);
+        queued.push_back(pos);
+    }
+
+    // Both scans count the positions to spawn, the update stops creating chunks after a limit but
+    // still checks all the offsets
+    int num_free_slots = 0;
+    const Clock::time_point slots_begin = Clock::now();
+    for (int update = 0; update < NUM_UPDATES; ++update)
+    {
+        for (const glm::ivec2 &offset : offsets)
+        {
+            const glm::ivec2 pos = center + offset;
+            if (chunks_map.getChunkState(pos) != ChunksMap::ChunkState::None
+                || chunks_map.isSlotBusy(pos))
+            {
+                continue;
+            }
+            ++num_free_slots;
+        }
+    }
+    const double slots_ms = get_ms(slots_begin, Clock::now()) / NUM_UPDATES;
+
+    int num_free_linear = 0;
+    const Clock::time_point linear_begin = Clock::now();
+    for (int update = 0; update < NUM_UPDATES; ++update)
+    {
+        for (const glm::ivec2 &offset : offsets)
+        {
+            const glm::ivec2 pos = center + offset;
+            if (chunks_map.hasChunk(pos)
+                || Alg::anyOf(queued, [&](const glm::ivec2 &p) { return p == pos; }))
+            {
+                continue;
+            }
+            ++num_free_linear;
+        }
+    }
+    const double linear_ms = get_ms(linear_begin, Clock::now()) / NUM_UPDATES;
+
+    const int expected_free = ((int)offsets.size() - NUM_QUEUED_CHUNKS) * NUM_UPDATES;
+    const bool passed = num_free_slots == expected_free && num_free_linear == expected_free;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"chunks_map\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"spawn_offsets\": %zu,\n", offsets.size());
+    fprintf(out, "    \"queued_chunks\": %d,\n", NUM_QUEUED_CHUNKS);
+    fprintf(out, "    \"map_radius\": %d,\n", RADIUS_UNLOAD_WHOLE_CHUNK);
+    fprintf(out, "    \"updates\": %d\n", NUM_UPDATES);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"update_ms\": {\"slot_states\": %.4f, \"linear_search\": %.4f},\n", slots_ms,
+        linear_ms);
+    fprintf(out, "  \"speedup\": %.1f,\n", slots_ms > 0.0 ? linear_ms / slots_ms : 0.0);
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
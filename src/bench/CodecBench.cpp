@@ -0,0 +1,190 @@
+// Chunk codec on generated terrain: round trips, rejection of corrupted streams, encode/decode
+// speed and the compression ratio
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "voxels/BasicBlocks.h"
+#include "voxels/BlocksRegistry.h"
+#include "voxels/Chunk.h"
+#include "voxels/ChunkCodec.h"
+#include "voxels/TerrainGenerator.h"
+
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+
+// Uncompressed blocks of a chunk, the MB/s are of these bytes
+constexpr uint64_t CHUNK_RAW_BYTES = (uint64_t)Chunk::NUM_BLOCKS * sizeof(BlockInfo);
+
+struct Random
+{
+    uint32_t next()
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    // [0, count)
+    uint32_t next(uint32_t count) { return next() % count; }
+
+    uint32_t state;
+};
+
+bool is_cleared(const Chunk &chunk)
+{
+    for (int i = 0; i < Chunk::NUM_SECTIONS; ++i)
+    {
+        if (chunk.getSectionState(i) != ChunkSection::State::Empty)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool has_same_blocks(const Chunk &lhs, const Chunk &rhs)
+{
+    for (int i = 0; i < Chunk::NUM_BLOCKS; ++i)
+    {
+        if (lhs.getBlock(i) != rhs.getBlock(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+double get_mb_per_sec(uint64_t bytes, double ms)
+{
+    return ms > 0.0 ? (double)bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+}
+
+} // namespace
+
+int bench::run_codec(const Settings &settings, FILE *out)
+{
+    BlocksRegistry registry;
+    BasicBlocks::registerBlocks(registry);
+    const int num_block_ids = registry.getNumBlocks();
+
+    // Same chunks as the generation of the game and the pipeline benchmark
+    const int num_chunks = settings.size * settings.size;
+    std::vector<UPtr<Chunk>> chunks(num_chunks);
+    run_parallel(get_num_threads(settings), num_chunks, [&](int index, int) {
+        UPtr<Chunk> chunk = makeU<Chunk>(
+            glm::ivec3{index % settings.size, 0, index / settings.size});
+        TerrainGenerator &generator = TerrainGenerator::getThreadGenerator(settings.seed);
+        generator.setCaveLatticeStep(settings.cave_lattice_step);
+        generator.generate(*chunk);
+        chunks[index] = std::move(chunk);
+    });
+
+    uint64_t chunks_memory = 0;
+    for (const UPtr<Chunk> &chunk : chunks)
+    {
+        chunks_memory += chunk->getMemoryUsage();
+    }
+
+    // Encoding and decoding on one thread, as the I/O thread does
+    std::vector<std::vector<uint8_t>> encoded(num_chunks);
+    const Clock::time_point encode_begin = Clock::now();
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        ChunkCodec::encode(*chunks[i], encoded[i]);
+    }
+    const double encode_ms = get_ms(encode_begin, Clock::now());
+
+    uint64_t encoded_bytes = 0;
+    for (const std::vector<uint8_t> &data : encoded)
+    {
+        encoded_bytes += data.size();
+    }
+
+    Chunk decoded(glm::ivec3{0, 0, 0});
+    int num_decoded = 0;
+    double decode_ms = 0.0;
+    int num_round_trips = 0;
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        decoded.clear();
+        const Clock::time_point begin = Clock::now();
+        const bool loaded = ChunkCodec::decode(encoded[i].data(), encoded[i].size(),
+            num_block_ids, decoded);
+        decode_ms += get_ms(begin, Clock::now());
+        num_decoded += loaded ? 1 : 0;
+        num_round_trips += loaded && has_same_blocks(*chunks[i], decoded) ? 1 : 0;
+    }
+
+    // Corrupted streams. Truncated ones must be rejected always. There is no checksum, so a flipped
+    // byte or garbage can decode to other valid blocks, such streams are only counted. A rejected
+    // chunk must be left cleared
+    Random random{settings.seed};
+    int num_truncated_rejected = 0;
+    int num_flipped_rejected = 0;
+    int num_garbage_rejected = 0;
+    int num_rejected_not_cleared = 0;
+    std::vector<uint8_t> corrupted;
+    const auto decode_corrupted = [&]() {
+        decoded.fillSection(0, BlockInfo(1));
+        const bool loaded = ChunkCodec::decode(corrupted.data(), corrupted.size(), num_block_ids,
+            decoded);
+        num_rejected_not_cleared += !loaded && !is_cleared(decoded) ? 1 : 0;
+        return loaded ? 0 : 1;
+    };
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        const std::vector<uint8_t> &data = encoded[i];
+        const uint32_t size = (uint32_t)data.size();
+
+        corrupted.assign(data.begin(), data.begin() + random.next(size));
+        num_truncated_rejected += decode_corrupted();
+
+        corrupted = data;
+        corrupted[random.next(size)] ^= (uint8_t)(1 + random.next(255));
+        num_flipped_rejected += decode_corrupted();
+
+        for (uint8_t &byte : corrupted)
+        {
+            byte = (uint8_t)random.next();
+        }
+        num_garbage_rejected += decode_corrupted();
+    }
+
+    const uint64_t raw_bytes = CHUNK_RAW_BYTES * num_chunks;
+    const bool passed = num_decoded == num_chunks && num_round_trips == num_chunks
+        && num_truncated_rejected == num_chunks && num_rejected_not_cleared == 0;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"codec\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"size\": %d,\n", settings.size);
+    fprintf(out, "    \"seed\": %u,\n", settings.seed);
+    fprintf(out, "    \"cave_lattice_step\": %d\n", settings.cave_lattice_step);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"chunks\": %d,\n", num_chunks);
+    fprintf(out, "  \"bytes\": {\n");
+    fprintf(out, "    \"raw\": %llu,\n", (unsigned long long)raw_bytes);
+    fprintf(out, "    \"chunks_memory\": %llu,\n", (unsigned long long)chunks_memory);
+    fprintf(out, "    \"encoded\": %llu,\n", (unsigned long long)encoded_bytes);
+    fprintf(out, "    \"encoded_per_chunk_avg\": %.1f\n", (double)encoded_bytes / num_chunks);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"ratio\": {\"raw\": %.1f, \"chunks_memory\": %.1f},\n",
+        (double)raw_bytes / encoded_bytes, (double)chunks_memory / encoded_bytes);
+    fprintf(out, "  \"encode\": {\"ms\": %.3f, \"raw_mb_per_sec\": %.1f},\n", encode_ms,
+        get_mb_per_sec(raw_bytes, encode_ms));
+    fprintf(out, "  \"decode\": {\"ms\": %.3f, \"raw_mb_per_sec\": %.1f},\n", decode_ms,
+        get_mb_per_sec(raw_bytes, decode_ms));
+    fprintf(out, "  \"round_trips\": %d,\n", num_round_trips);
+    fprintf(out, "  \"corrupted\": {\n");
+    fprintf(out, "    \"truncated_rejected\": %d,\n", num_truncated_rejected);
+    fprintf(out, "    \"flipped_byte_rejected\": %d,\n", num_flipped_rejected);
+    fprintf(out, "    \"garbage_rejected\": %d,\n", num_garbage_rejected);
+    fprintf(out, "    \"rejected_not_cleared\": %d\n", num_rejected_not_cleared);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
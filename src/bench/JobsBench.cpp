@@ -0,0 +1,136 @@
+// Throughput of the job queue with 1..N workers: empty jobs enqueued from the main thread (the
+// lock-free queues of the priority classes) and spawned by the workers (the work-stealing
+// deques). A job is done when its finishMainThread() is called, as the game's jobs are
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "EngineGlobals.h"
+#include "threads/Job.h"
+#include "threads/JobQueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+
+constexpr int NUM_JOBS = 100000;
+// Spawned jobs per root job in the worker spawn case
+constexpr int NUM_CHILDREN = 63;
+
+struct Counters
+{
+    std::atomic<int> executed{0};
+    int finished{0}; // main thread
+};
+
+class CountJob final : public tbb::Job
+{
+public:
+    CountJob(Counters &counters, int num_children)
+        : counters_(counters)
+        , num_children_(num_children)
+    {}
+
+    void execute() override
+    {
+        for (int i = 0; i < num_children_; ++i)
+        {
+            eng.queue->enqueueJob(makeU<CountJob>(counters_, 0));
+        }
+        counters_.executed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finishMainThread() override { ++counters_.finished; }
+
+private:
+    Counters &counters_;
+    const int num_children_;
+};
+
+struct CaseResult
+{
+    double ms{0.0};
+    int executed{0};
+};
+
+CaseResult run_case(int num_workers, int num_children)
+{
+    tbb::JobQueueSettings queue_settings;
+    queue_settings.num_threads = num_workers;
+    queue_settings.low_priority_workers = false;
+    tbb::JobQueue queue(queue_settings);
+    eng.queue = &queue;
+    queue.runWorkers();
+
+    Counters counters;
+    const int num_roots = NUM_JOBS / (num_children + 1);
+    const int num_jobs = num_roots * (num_children + 1);
+
+    const Clock::time_point begin = Clock::now();
+    for (int i = 0; i < num_roots; ++i)
+    {
+        queue.enqueueJob(makeU<CountJob>(counters, num_children));
+    }
+    while (counters.finished < num_jobs)
+    {
+        const int finished = counters.finished;
+        queue.finishJobsMainThread();
+        if (counters.finished == finished)
+        {
+            std::this_thread::yield();
+        }
+    }
+    CaseResult result;
+    result.ms = get_ms(begin, Clock::now());
+    result.executed = counters.executed.load();
+
+    queue.stopWorkers();
+    eng.queue = nullptr;
+    return result;
+}
+
+double get_jobs_per_sec(int num_jobs, double ms)
+{
+    return ms > 0.0 ? num_jobs * 1000.0 / ms : 0.0;
+}
+
+} // namespace
+
+int bench::run_jobs(const Settings &settings, FILE *out)
+{
+    const int max_workers = get_num_threads(settings);
+    const int num_spawned_jobs = NUM_JOBS / (NUM_CHILDREN + 1) * (NUM_CHILDREN + 1);
+    bool passed = true;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"jobs\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"max_workers\": %d,\n", max_workers);
+    fprintf(out, "    \"jobs\": %d,\n", NUM_JOBS);
+    fprintf(out, "    \"spawned_per_root_job\": %d\n", NUM_CHILDREN);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"workers\": [\n");
+    for (int workers = 1; workers <= max_workers; ++workers)
+    {
+        const CaseResult enqueued = run_case(workers, 0);
+        const CaseResult spawned = run_case(workers, NUM_CHILDREN);
+        passed = passed && enqueued.executed == NUM_JOBS && spawned.executed == num_spawned_jobs;
+
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"workers\": %d,\n", workers);
+        fprintf(out, "      \"main_enqueue\": {\"ms\": %.3f, \"jobs_per_sec\": %.0f},\n",
+            enqueued.ms, get_jobs_per_sec(NUM_JOBS, enqueued.ms));
+        fprintf(out, "      \"worker_spawn\": {\"ms\": %.3f, \"jobs_per_sec\": %.0f}\n",
+            spawned.ms, get_jobs_per_sec(num_spawned_jobs, spawned.ms));
+        fprintf(out, "    }%s\n", workers < max_workers ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
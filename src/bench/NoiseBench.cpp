@@ -0,0 +1,233 @@
+// Accuracy and speed of the batch noise against the scalar libnoise GetValue, near the origin and
+// far from it
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "voxels/TerrainGenerator.h"
+#include "voxels/noise/BatchNoise.h"
+#include "voxels/noise/MapToMinMax.h"
+
+#include <noise/noise.h>
+
+#include <utility>
+#include <vector>
+
+using namespace bench;
+using namespace noise::module;
+
+namespace
+{
+
+constexpr int NUM_POINTS = 4096;
+// Noise values are about -1..+1, the height maps of the terrain are checked in blocks
+constexpr double MAX_MODULE_ERROR = 1e-4;
+
+struct Location
+{
+    const char *name;
+    double offset; // in blocks, x and z
+};
+
+constexpr Location LOCATIONS[] = {
+    {"near", 0.0},
+    {"1e5", 1e5},
+    {"-1e5", -1e5},
+    {"1e6", 1e6},
+    {"-1e6", -1e6},
+};
+constexpr int NUM_LOCATIONS = (int)(sizeof(LOCATIONS) / sizeof(LOCATIONS[0]));
+
+struct Points
+{
+    double x[NUM_POINTS];
+    double y[NUM_POINTS];
+    double z[NUM_POINTS];
+};
+
+// 64 x 64 points around the offset with fractional coordinates, y covers the chunk height
+void init_points(double offset, unsigned int seed, Points &points)
+{
+    unsigned int state = seed;
+    const auto next_fraction = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (double)(state >> 8) / (double)(1u << 24);
+    };
+    for (int i = 0; i < NUM_POINTS; ++i)
+    {
+        points.x[i] = offset + (double)(i % 64) * 4.0 + next_fraction();
+        points.y[i] = (double)(i / 64) * 4.0 + next_fraction();
+        points.z[i] = offset + (double)(i / 64) * 4.0 + next_fraction();
+    }
+}
+
+// All the modules that the batch noise evaluates, with the default parameters and the ones of the
+// terrain (lower frequencies)
+struct Modules
+{
+    explicit Modules(int seed)
+    {
+        perlin.SetSeed(seed);
+        terrain_perlin.SetSeed(seed);
+        terrain_perlin.SetFrequency(0.002 * 0.8);
+        terrain_perlin.SetPersistence(0.4);
+        billow.SetSeed(seed);
+        ridged_multi.SetSeed(seed);
+        terrain_ridged_multi.SetSeed(seed);
+        terrain_ridged_multi.SetFrequency(0.002);
+
+        scale_bias.SetSourceModule(0, billow);
+        scale_bias.SetScale(0.095);
+        scale_bias.SetBias(-0.95);
+
+        add.SetSourceModule(0, perlin);
+        add.SetSourceModule(1, billow);
+
+        select.SetSourceModule(0, scale_bias);
+        select.SetSourceModule(1, ridged_multi);
+        select.SetControlModule(terrain_perlin);
+        select.SetBounds(0.4, 1000);
+        select.SetEdgeFalloff(0.1);
+
+        turbulence.SetSeed(seed);
+        turbulence.SetSourceModule(0, perlin);
+        turbulence.SetPower(0.25);
+        terrain_turbulence.SetSeed(seed);
+        terrain_turbulence.SetSourceModule(0, terrain_ridged_multi);
+        terrain_turbulence.SetFrequency(0.002 * 4);
+        terrain_turbulence.SetPower(4);
+
+        map_to_min_max.SetSourceModule(0, perlin);
+        map_to_min_max.SetMinAndHeight(-1, 2);
+    }
+
+    Perlin perlin;
+    Perlin terrain_perlin;
+    Billow billow;
+    RidgedMulti ridged_multi;
+    RidgedMulti terrain_ridged_multi;
+    ScaleBias scale_bias;
+    Add add;
+    Select select;
+    Turbulence turbulence;
+    Turbulence terrain_turbulence;
+    MapToMinMax map_to_min_max;
+};
+
+struct ModuleResult
+{
+    const char *name;
+    double max_error[NUM_LOCATIONS]{};
+    double batch_ns_per_point{0.0};
+    double scalar_ns_per_point{0.0};
+};
+
+double get_ns_per_point(Clock::time_point begin, Clock::time_point end)
+{
+    return get_ms(begin, end) * 1e6 / NUM_POINTS;
+}
+
+} // namespace
+
+int bench::run_noise(const Settings &settings, FILE *out)
+{
+    const UPtr<Modules> modules = makeU<Modules>((int)settings.seed);
+    const std::pair<const char *, const Module *> tested[] = {
+        {"perlin", &modules->perlin},
+        {"terrain_perlin", &modules->terrain_perlin},
+        {"billow", &modules->billow},
+        {"ridged_multi", &modules->ridged_multi},
+        {"terrain_ridged_multi", &modules->terrain_ridged_multi},
+        {"scale_bias", &modules->scale_bias},
+        {"add", &modules->add},
+        {"select", &modules->select},
+        {"turbulence", &modules->turbulence},
+        {"terrain_turbulence", &modules->terrain_turbulence},
+        {"map_to_min_max", &modules->map_to_min_max},
+    };
+    const int num_tested = (int)(sizeof(tested) / sizeof(tested[0]));
+
+    std::vector<ModuleResult> results(num_tested);
+    std::vector<float> values(NUM_POINTS);
+    const UPtr<Points> points = makeU<Points>();
+    bool passed = true;
+
+    for (int location = 0; location < NUM_LOCATIONS; ++location)
+    {
+        init_points(LOCATIONS[location].offset, settings.seed, *points);
+        for (int i = 0; i < num_tested; ++i)
+        {
+            const Module &module = *tested[i].second;
+            ModuleResult &result = results[i];
+            result.name = tested[i].first;
+            result.max_error[location] = noise::batch::GetMaxError(module, points->x, points->y,
+                points->z, NUM_POINTS);
+            passed = passed && result.max_error[location] < MAX_MODULE_ERROR;
+
+            if (location != 0)
+            {
+                continue;
+            }
+            const Clock::time_point batch_begin = Clock::now();
+            noise::batch::GetValues(module, points->x, points->y, points->z, NUM_POINTS,
+                values.data());
+            const Clock::time_point scalar_begin = Clock::now();
+            for (int p = 0; p < NUM_POINTS; ++p)
+            {
+                values[p] = (float)module.GetValue(points->x[p], points->y[p], points->z[p]);
+            }
+            const Clock::time_point scalar_end = Clock::now();
+            result.batch_ns_per_point = get_ns_per_point(batch_begin, scalar_begin);
+            result.scalar_ns_per_point = get_ns_per_point(scalar_begin, scalar_end);
+        }
+    }
+
+    // Height maps of the terrain graph, same check as the debug one of the generator
+    const UPtr<TerrainGenerator> generator = makeU<TerrainGenerator>(settings.seed);
+    double terrain_error[NUM_LOCATIONS];
+    for (int location = 0; location < NUM_LOCATIONS; ++location)
+    {
+        const float offset = (float)LOCATIONS[location].offset;
+        terrain_error[location] = generator->getMaxBatchNoiseError(glm::vec2(offset, offset));
+        passed = passed && terrain_error[location] < TerrainGenerator::MAX_BATCH_NOISE_ERROR;
+    }
+
+    const auto write_errors = [out](const double *errors) {
+        for (int location = 0; location < NUM_LOCATIONS; ++location)
+        {
+            fprintf(out, "%s\"%s\": %.3g", location == 0 ? "" : ", ", LOCATIONS[location].name,
+                errors[location]);
+        }
+    };
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"noise\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"seed\": %u,\n", settings.seed);
+    fprintf(out, "    \"points\": %d,\n", NUM_POINTS);
+    fprintf(out, "    \"simd_noise\": %s\n", noise::batch::IsSimdEnabled() ? "true" : "false");
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"modules\": {\n");
+    for (int i = 0; i < num_tested; ++i)
+    {
+        const ModuleResult &result = results[i];
+        fprintf(out, "    \"%s\": {\n", result.name);
+        fprintf(out, "      \"max_error\": {");
+        write_errors(result.max_error);
+        fprintf(out, "},\n");
+        fprintf(out, "      \"batch_ns_per_point\": %.1f,\n", result.batch_ns_per_point);
+        fprintf(out, "      \"scalar_ns_per_point\": %.1f\n", result.scalar_ns_per_point);
+        fprintf(out, "    }%s\n", i + 1 < num_tested ? "," : "");
+    }
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"max_module_error\": %g,\n", MAX_MODULE_ERROR);
+    fprintf(out, "  \"terrain_height_maps\": {\n");
+    fprintf(out, "    \"max_error_blocks\": {");
+    write_errors(terrain_error);
+    fprintf(out, "},\n");
+    fprintf(out, "    \"max_allowed_blocks\": %g\n", TerrainGenerator::MAX_BATCH_NOISE_ERROR);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// Terrain generation, mesh snapshots and the mesher of size x size chunks
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "voxels/BasicBlocks.h"
+#include "voxels/BlocksRegistry.h"
+#include "voxels/Chunk.h"
+#include "voxels/ChunkMeshData.h"
+#include "voxels/ChunkMeshSnapshot.h"
+#include "voxels/Common.h"
+#include "voxels/TerrainGenerator.h"
+#include "voxels/noise/BatchNoise.h"
+
+#include <algorithm>
+
+using namespace bench;
+
+namespace
+{
+
+struct StageResult
+{
+    double wall_ms{0.0};
+    std::vector<double> chunk_ms; // per chunk, the order isn't kept
+};
+
+void write_stage(FILE *out, const char *name, StageResult stage, bool last)
+{
+    std::sort(stage.chunk_ms.begin(), stage.chunk_ms.end());
+    double sum_ms = 0.0;
+    for (double ms : stage.chunk_ms)
+    {
+        sum_ms += ms;
+    }
+    const size_t count = stage.chunk_ms.size();
+    const double chunks_per_sec = stage.wall_ms > 0.0 ? count * 1000.0 / stage.wall_ms : 0.0;
+
+    fprintf(out, "    \"%s\": {\n", name);
+    fprintf(out, "      \"chunks\": %zu,\n", count);
+    fprintf(out, "      \"wall_ms\": %.3f,\n", stage.wall_ms);
+    fprintf(out, "      \"cpu_ms\": %.3f,\n", sum_ms);
+    fprintf(out, "      \"chunks_per_sec\": %.1f,\n", chunks_per_sec);
+    fprintf(out,
+        "      \"chunk_ms\": {\"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"max\": %.4f}\n",
+        count > 0 ? sum_ms / count : 0.0, get_percentile(stage.chunk_ms, 0.5),
+        get_percentile(stage.chunk_ms, 0.95), count > 0 ? stage.chunk_ms.back() : 0.0);
+    fprintf(out, "    }%s\n", last ? "" : ",");
+}
+
+} // namespace
+
+int bench::run_pipeline(const Settings &settings, FILE *out)
+{
+    const int num_threads = get_num_threads(settings);
+
+    BlocksRegistry registry;
+    BasicBlocks::registerBlocks(registry);
+
+    // Built once per thread in the game too, measured separately from the chunks
+    const Clock::time_point init_begin = Clock::now();
+    TerrainGenerator::getThreadGenerator(settings.seed);
+    const double generator_init_ms = get_ms(init_begin, Clock::now());
+
+    // Generation
+    const int generated_width = settings.size + 2;
+    std::vector<UPtr<Chunk>> chunks(generated_width * generated_width);
+    const auto get_chunk = [&](int x, int z) { return chunks[z * generated_width + x].get(); };
+
+    std::vector<StageResult> thread_generate(num_threads);
+    const Clock::time_point generate_begin = Clock::now();
+    run_parallel(num_threads, (int)chunks.size(), [&](int index, int thread_index) {
+        const Clock::time_point begin = Clock::now();
+        const int x = index % generated_width;
+        const int z = index / generated_width;
+        UPtr<Chunk> chunk = makeU<Chunk>(glm::ivec3{x, 0, z});
+
+        TerrainGenerator &generator = TerrainGenerator::getThreadGenerator(settings.seed);
+        generator.setCaveLatticeStep(settings.cave_lattice_step);
+        generator.generate(*chunk);
+
+        chunks[index] = std::move(chunk);
+        thread_generate[thread_index].chunk_ms.push_back(get_ms(begin, Clock::now()));
+    });
+    StageResult generate;
+    generate.wall_ms = get_ms(generate_begin, Clock::now());
+
+    uint64_t chunks_memory = 0;
+    for (const UPtr<Chunk> &chunk : chunks)
+    {
+        chunks_memory += chunk->getMemoryUsage();
+    }
+
+    // Snapshots and meshes of the inner chunks, the snapshot is copied in the main thread in the
+    // game, here both are done by the same thread
+    const int num_meshed = settings.size * settings.size;
+    std::vector<int> num_vertices(num_meshed, 0);
+    std::vector<StageResult> thread_snapshot(num_threads);
+    std::vector<StageResult> thread_mesh(num_threads);
+    const Clock::time_point mesh_begin = Clock::now();
+    run_parallel(num_threads, num_meshed, [&](int index, int thread_index) {
+        static thread_local UPtr<ChunkMeshSnapshot> snapshot;
+        static thread_local UPtr<ChunkMeshGenerator> generator;
+        static thread_local ChunkMeshData mesh_data;
+        if (!snapshot)
+        {
+            snapshot = makeU<ChunkMeshSnapshot>();
+            generator = makeU<ChunkMeshGenerator>();
+        }
+
+        const int x = index % settings.size + 1;
+        const int z = index / settings.size + 1;
+        ExtendedNeighbourChunks neighbours;
+        neighbours.nx_nz = get_chunk(x - 1, z - 1);
+        neighbours.nz = get_chunk(x, z - 1);
+        neighbours.px_nz = get_chunk(x + 1, z - 1);
+        neighbours.nx = get_chunk(x - 1, z);
+        neighbours.px = get_chunk(x + 1, z);
+        neighbours.nx_pz = get_chunk(x - 1, z + 1);
+        neighbours.pz = get_chunk(x, z + 1);
+        neighbours.px_pz = get_chunk(x + 1, z + 1);
+
+        const Clock::time_point begin = Clock::now();
+        snapshot->init(*get_chunk(x, z), neighbours, registry);
+        const Clock::time_point snapshot_end = Clock::now();
+        generator->setMode(settings.mode);
+        generator->buildMesh(*snapshot, mesh_data);
+        const Clock::time_point end = Clock::now();
+
+        num_vertices[index] = mesh_data.getNumVertices();
+        thread_snapshot[thread_index].chunk_ms.push_back(get_ms(begin, snapshot_end));
+        thread_mesh[thread_index].chunk_ms.push_back(get_ms(snapshot_end, end));
+    });
+    const double mesh_wall_ms = get_ms(mesh_begin, Clock::now());
+
+    StageResult snapshot;
+    StageResult mesh;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        const auto append = [](StageResult &to, const StageResult &from) {
+            to.chunk_ms.insert(to.chunk_ms.end(), from.chunk_ms.begin(), from.chunk_ms.end());
+        };
+        append(generate, thread_generate[i]);
+        append(snapshot, thread_snapshot[i]);
+        append(mesh, thread_mesh[i]);
+    }
+    // Interleaved in the same jobs, the wall time is split by the CPU time of the stages
+    double snapshot_cpu_ms = 0.0;
+    double mesh_cpu_ms = 0.0;
+    for (double ms : snapshot.chunk_ms)
+    {
+        snapshot_cpu_ms += ms;
+    }
+    for (double ms : mesh.chunk_ms)
+    {
+        mesh_cpu_ms += ms;
+    }
+    const double meshing_cpu_ms = snapshot_cpu_ms + mesh_cpu_ms;
+    snapshot.wall_ms = meshing_cpu_ms > 0.0 ? mesh_wall_ms * snapshot_cpu_ms / meshing_cpu_ms : 0.0;
+    mesh.wall_ms = mesh_wall_ms - snapshot.wall_ms;
+
+    uint64_t total_vertices = 0;
+    int max_vertices = 0;
+    for (int count : num_vertices)
+    {
+        total_vertices += count;
+        max_vertices = std::max(max_vertices, count);
+    }
+    const double total_ms = generate.wall_ms + mesh_wall_ms;
+    // Meshed chunks per second of the whole pipeline, the border chunks are generated only
+    const double chunks_per_sec = total_ms > 0.0 ? num_meshed * 1000.0 / total_ms : 0.0;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"pipeline\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"size\": %d,\n", settings.size);
+    fprintf(out, "    \"seed\": %u,\n", settings.seed);
+    fprintf(out, "    \"threads\": %d,\n", num_threads);
+    fprintf(out, "    \"mesh_mode\": \"%s\",\n",
+        settings.mode == ChunkMeshGenerator::Mode::Greedy ? "greedy" : "naive");
+    fprintf(out, "    \"cave_lattice_step\": %d,\n", settings.cave_lattice_step);
+    fprintf(out, "    \"simd_noise\": %s\n", noise::batch::IsSimdEnabled() ? "true" : "false");
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"chunks_generated\": %zu,\n", chunks.size());
+    fprintf(out, "  \"chunks_meshed\": %d,\n", num_meshed);
+    fprintf(out, "  \"chunks_per_sec\": %.1f,\n", chunks_per_sec);
+    fprintf(out, "  \"total_ms\": %.3f,\n", total_ms);
+    fprintf(out, "  \"terrain_generator_init_ms\": %.3f,\n", generator_init_ms);
+    fprintf(out, "  \"stages\": {\n");
+    write_stage(out, "generate", generate, false);
+    write_stage(out, "snapshot", snapshot, false);
+    write_stage(out, "mesh", mesh, true);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"vertices\": {\n");
+    fprintf(out, "    \"total\": %llu,\n", (unsigned long long)total_vertices);
+    fprintf(out, "    \"per_chunk_avg\": %.1f,\n", (double)total_vertices / num_meshed);
+    fprintf(out, "    \"per_chunk_max\": %d,\n", max_vertices);
+    fprintf(out, "    \"bytes\": %llu\n",
+        (unsigned long long)(total_vertices * sizeof(ChunkMeshData::Vertex)));
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"memory\": {\n");
+    fprintf(out, "    \"chunks_bytes\": %llu,\n", (unsigned long long)chunks_memory);
+    fprintf(out, "    \"peak_rss_bytes\": %llu\n", (unsigned long long)get_peak_memory_bytes());
+    fprintf(out, "  }\n");
+    fprintf(out, "}\n");
+
+    return 0;
+}
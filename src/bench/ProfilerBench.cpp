@@ -0,0 +1,103 @@
+// Overhead of one profiled scope (an enter and a leave probe) on the calling thread, the same
+// code as SCOPED_PROFILER expands to. The bench is built without REALENGINE_ENABLE_PROFILER, the
+// ScopedProfiler is used directly
+
+#include "Bench.h"
+
+#include "profiler/ScopedProfiler.h"
+
+#include <algorithm>
+
+using namespace bench;
+
+namespace
+{
+
+constexpr int NUM_SCOPES = 1 << 22;
+constexpr int NUM_RUNS = 5;
+// The target of the whole scope, it holds where the clock read is cheap (TSC of a bare metal CPU
+// is ~7 ns, a virtualized one may be 3 times slower). The check is of the probes writing
+constexpr double TARGET_SCOPE_OVERHEAD_NS = 20.0;
+constexpr double MAX_RECORD_OVERHEAD_NS = 8.0;
+
+constexpr ProbeSite BENCH_SITE{"Profiler bench scope", __FILE__, __LINE__};
+
+// Keeps the loops from being removed or merged
+volatile int g_sink = 0;
+
+double run_empty()
+{
+    const Clock::time_point begin = Clock::now();
+    for (int i = 0; i < NUM_SCOPES; ++i)
+    {
+        g_sink = i;
+    }
+    return get_ms(begin, Clock::now());
+}
+
+double run_clock()
+{
+    const Clock::time_point begin = Clock::now();
+    for (int i = 0; i < NUM_SCOPES; ++i)
+    {
+        g_sink = (int)Profiler::getTicks();
+    }
+    return get_ms(begin, Clock::now());
+}
+
+double run_scoped()
+{
+    const Clock::time_point begin = Clock::now();
+    for (int i = 0; i < NUM_SCOPES; ++i)
+    {
+        ScopedProfiler profiler(&BENCH_SITE);
+        g_sink = i;
+    }
+    return get_ms(begin, Clock::now());
+}
+
+} // namespace
+
+int bench::run_profiler(const Settings &settings, FILE *out)
+{
+    (void)settings;
+
+    Profiler::init();
+    // Registers the thread, the first probe of a thread allocates its buffers
+    run_scoped();
+
+    // The best of the runs, the others are slowed down by the interrupts and the other processes
+    double empty_ms = run_empty();
+    double clock_ms = run_clock();
+    double scoped_ms = run_scoped();
+    for (int run = 1; run < NUM_RUNS; ++run)
+    {
+        empty_ms = std::min(empty_ms, run_empty());
+        clock_ms = std::min(clock_ms, run_clock());
+        scoped_ms = std::min(scoped_ms, run_scoped());
+    }
+
+    const auto get_ns = [](double ms) { return std::max(ms, 0.0) * 1e6 / NUM_SCOPES; };
+    const double scope_ns = get_ns(scoped_ms - empty_ms);
+    const double clock_ns = get_ns(clock_ms - empty_ms);
+    // Everything but the two clock reads
+    const double record_ns = std::max(scope_ns - 2.0 * clock_ns, 0.0);
+    const bool passed = record_ns < MAX_RECORD_OVERHEAD_NS;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"profiler\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"scopes\": %d,\n", NUM_SCOPES);
+    fprintf(out, "    \"runs\": %d\n", NUM_RUNS);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"empty_loop_ms\": %.3f,\n", empty_ms);
+    fprintf(out, "  \"scoped_loop_ms\": %.3f,\n", scoped_ms);
+    fprintf(out, "  \"scope_overhead_ns\": %.2f,\n", scope_ns);
+    fprintf(out, "  \"target_scope_overhead_ns\": %.1f,\n", TARGET_SCOPE_OVERHEAD_NS);
+    fprintf(out, "  \"clock_read_ns\": %.2f,\n", clock_ns);
+    fprintf(out, "  \"record_overhead_ns\": %.2f,\n", record_ns);
+    fprintf(out, "  \"max_record_overhead_ns\": %.1f,\n", MAX_RECORD_OVERHEAD_NS);
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
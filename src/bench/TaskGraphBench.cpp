@@ -0,0 +1,267 @@
+// Checks of the task graph and parallelFor on the job queue: a diamond graph run asynchronously
+// (the continuation is called by the main thread's job finishing) and with wait(), a random DAG,
+// parallelFor nested in a task. Every case is repeated to catch the races
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "EngineGlobals.h"
+#include "threads/JobQueue.h"
+#include "threads/Parallel.h"
+#include "threads/Threads.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+
+constexpr int NUM_REPEATS = 200;
+constexpr int NUM_DAG_TASKS = 500;
+constexpr int NUM_DAG_EDGES_PER_TASK = 3;
+constexpr int PARALLEL_FOR_SIZE = 10000;
+constexpr int PARALLEL_FOR_GRAIN = 64;
+constexpr double TIMEOUT_MS = 10000.0;
+
+struct CaseResult
+{
+    const char *name;
+    int failed{0};
+    double ms{0.0};
+};
+
+// The order of the task executions, the step of each task
+struct Steps
+{
+    explicit Steps(int num_tasks)
+        : task_steps(num_tasks)
+    {
+        for (std::atomic<int> &step : task_steps)
+        {
+            step.store(-1);
+        }
+    }
+
+    void record(int task)
+    {
+        const int step = next_step.fetch_add(1);
+        // Executed once
+        if (task_steps[task].exchange(step) != -1)
+        {
+            executed_twice = true;
+        }
+    }
+
+    bool isBefore(int before, int after) const
+    {
+        const int before_step = task_steps[before].load();
+        const int after_step = task_steps[after].load();
+        return before_step >= 0 && after_step >= 0 && before_step < after_step;
+    }
+
+    std::atomic<int> next_step{0};
+    std::vector<std::atomic<int>> task_steps;
+    std::atomic<bool> executed_twice{false};
+};
+
+struct Continuation
+{
+    bool called{false};
+    bool on_main_thread{false};
+    int num_steps{0}; // tasks executed before the call
+};
+
+// The continuation of a run() graph is called by the job finishing on the main thread
+bool wait_for_continuation(const Continuation &continuation)
+{
+    const Clock::time_point begin = Clock::now();
+    while (!continuation.called)
+    {
+        eng.queue->finishJobsMainThread();
+        if (get_ms(begin, Clock::now()) > TIMEOUT_MS)
+        {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+//  0
+// 1 2
+//  3
+bool run_diamond(bool wait)
+{
+    Steps steps(4);
+    Continuation continuation;
+
+    tbb::TaskGraph graph;
+    for (int i = 0; i < 4; ++i)
+    {
+        graph.addTask([&steps, i]() { steps.record(i); });
+    }
+    graph.addDependency(0, 1);
+    graph.addDependency(0, 2);
+    graph.addDependency(1, 3);
+    graph.addDependency(2, 3);
+    graph.setContinuation([&]() {
+        continuation.called = true;
+        continuation.on_main_thread = Threads::isMainThread();
+        continuation.num_steps = steps.next_step.load();
+    });
+    graph.run();
+
+    if (wait)
+    {
+        graph.wait();
+    }
+    else if (!wait_for_continuation(continuation))
+    {
+        return false;
+    }
+
+    return graph.isFinished() && !steps.executed_twice && steps.isBefore(0, 1)
+        && steps.isBefore(0, 2) && steps.isBefore(1, 3) && steps.isBefore(2, 3)
+        && continuation.called && continuation.on_main_thread && continuation.num_steps == 4;
+}
+
+// Every task depends on a few random earlier ones
+bool run_random_dag(uint32_t seed)
+{
+    Steps steps(NUM_DAG_TASKS);
+    Continuation continuation;
+    std::vector<std::vector<int>> predecessors(NUM_DAG_TASKS);
+
+    tbb::TaskGraph graph;
+    uint32_t state = seed;
+    for (int i = 0; i < NUM_DAG_TASKS; ++i)
+    {
+        graph.addTask([&steps, i]() { steps.record(i); });
+        for (int edge = 0; edge < NUM_DAG_EDGES_PER_TASK && i > 0; ++edge)
+        {
+            state = state * 1664525u + 1013904223u;
+            const int before = (int)((state >> 8) % (uint32_t)i);
+            graph.addDependency(before, i);
+            predecessors[i].push_back(before);
+        }
+    }
+    graph.setContinuation([&]() {
+        continuation.called = true;
+        continuation.on_main_thread = Threads::isMainThread();
+        continuation.num_steps = steps.next_step.load();
+    });
+    graph.run();
+    if (!wait_for_continuation(continuation))
+    {
+        return false;
+    }
+
+    bool ordered = true;
+    for (int i = 0; i < NUM_DAG_TASKS; ++i)
+    {
+        for (const int before : predecessors[i])
+        {
+            ordered = ordered && steps.isBefore(before, i);
+        }
+    }
+    return ordered && !steps.executed_twice && continuation.on_main_thread
+        && continuation.num_steps == NUM_DAG_TASKS;
+}
+
+// parallelFor called from the tasks, i.e. from the worker jobs and the waiting main thread
+bool run_nested_parallel_for()
+{
+    constexpr int NUM_TASKS = 4;
+    std::vector<std::atomic<int>> visits(NUM_TASKS * PARALLEL_FOR_SIZE);
+    for (std::atomic<int> &count : visits)
+    {
+        count.store(0);
+    }
+
+    tbb::TaskGraph graph;
+    for (int task = 0; task < NUM_TASKS; ++task)
+    {
+        graph.addTask([&visits, task]() {
+            std::atomic<int> *task_visits = visits.data() + task * PARALLEL_FOR_SIZE;
+            tbb::parallelFor(0, PARALLEL_FOR_SIZE, PARALLEL_FOR_GRAIN, [&](int begin, int end) {
+                for (int i = begin; i < end; ++i)
+                {
+                    task_visits[i].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        });
+    }
+    graph.run();
+    graph.wait();
+
+    for (const std::atomic<int> &count : visits)
+    {
+        if (count.load() != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int bench::run_task_graph(const Settings &settings, FILE *out)
+{
+    const int num_workers = get_num_threads(settings);
+
+    tbb::JobQueueSettings queue_settings;
+    queue_settings.num_threads = num_workers;
+    queue_settings.low_priority_workers = false;
+    tbb::JobQueue queue(queue_settings);
+    eng.queue = &queue;
+    queue.runWorkers();
+
+    CaseResult results[] = {
+        {"diamond_run"},
+        {"diamond_wait"},
+        {"random_dag"},
+        {"nested_parallel_for"},
+    };
+    for (int repeat = 0; repeat < NUM_REPEATS; ++repeat)
+    {
+        const auto run_case = [](CaseResult &result, const auto &fn) {
+            const Clock::time_point begin = Clock::now();
+            result.failed += fn() ? 0 : 1;
+            result.ms += get_ms(begin, Clock::now());
+        };
+        run_case(results[0], []() { return run_diamond(false); });
+        run_case(results[1], []() { return run_diamond(true); });
+        run_case(results[2], [&]() { return run_random_dag(settings.seed + repeat); });
+        run_case(results[3], []() { return run_nested_parallel_for(); });
+    }
+
+    // The continuation jobs of the waited graphs are still queued, they do nothing
+    queue.finishJobsMainThread();
+    queue.stopWorkers();
+    eng.queue = nullptr;
+
+    bool passed = true;
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"task_graph\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"workers\": %d,\n", num_workers);
+    fprintf(out, "    \"repeats\": %d\n", NUM_REPEATS);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"cases\": {\n");
+    const int num_cases = (int)(sizeof(results) / sizeof(results[0]));
+    for (int i = 0; i < num_cases; ++i)
+    {
+        const CaseResult &result = results[i];
+        passed = passed && result.failed == 0;
+        fprintf(out, "    \"%s\": {\"failed\": %d, \"avg_ms\": %.4f}%s\n", result.name,
+            result.failed, result.ms / NUM_REPEATS, i + 1 < num_cases ? "," : "");
+    }
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+// Terrain generation with the noise modules graph built for every chunk and with the graph
+// reused by the thread (TerrainGenerator::getThreadGenerator), on one thread
+
+#include "Bench.h"
+
+#include "Base.h"
+#include "voxels/Chunk.h"
+#include "voxels/TerrainGenerator.h"
+
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+
+struct RunResult
+{
+    double ms{0.0};
+    double graph_ms{0.0};
+};
+
+double get_chunks_per_sec(int num_chunks, double ms)
+{
+    return ms > 0.0 ? num_chunks * 1000.0 / ms : 0.0;
+}
+
+} // namespace
+
+int bench::run_terrain(const Settings &settings, FILE *out)
+{
+    const int num_chunks = settings.size * settings.size;
+    const auto make_chunk = [&](int index) {
+        return makeU<Chunk>(glm::ivec3{index % settings.size, 0, index / settings.size});
+    };
+
+    // Warm up the caches and the thread generator
+    TerrainGenerator &thread_generator = TerrainGenerator::getThreadGenerator(settings.seed);
+    thread_generator.setCaveLatticeStep(settings.cave_lattice_step);
+    thread_generator.generate(*make_chunk(0));
+
+    std::vector<UPtr<Chunk>> per_chunk_chunks(num_chunks);
+    RunResult per_chunk;
+    const Clock::time_point per_chunk_begin = Clock::now();
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        const Clock::time_point graph_begin = Clock::now();
+        TerrainGenerator generator(settings.seed);
+        generator.setCaveLatticeStep(settings.cave_lattice_step);
+        per_chunk.graph_ms += get_ms(graph_begin, Clock::now());
+
+        per_chunk_chunks[i] = make_chunk(i);
+        generator.generate(*per_chunk_chunks[i]);
+    }
+    per_chunk.ms = get_ms(per_chunk_begin, Clock::now());
+
+    std::vector<UPtr<Chunk>> reused_chunks(num_chunks);
+    RunResult reused;
+    const Clock::time_point reused_begin = Clock::now();
+    for (int i = 0; i < num_chunks; ++i)
+    {
+        TerrainGenerator &generator = TerrainGenerator::getThreadGenerator(settings.seed);
+        reused_chunks[i] = make_chunk(i);
+        generator.generate(*reused_chunks[i]);
+    }
+    reused.ms = get_ms(reused_begin, Clock::now());
+
+    bool passed = true;
+    for (int i = 0; i < num_chunks && passed; ++i)
+    {
+        for (int block = 0; block < Chunk::NUM_BLOCKS; ++block)
+        {
+            if (per_chunk_chunks[i]->getBlock(block) != reused_chunks[i]->getBlock(block))
+            {
+                passed = false;
+                break;
+            }
+        }
+    }
+
+    const double graph_ms_per_chunk = per_chunk.graph_ms / num_chunks;
+    const double generate_ms_per_chunk = (per_chunk.ms - per_chunk.graph_ms) / num_chunks;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"bench\": \"terrain\",\n");
+    fprintf(out, "  \"settings\": {\n");
+    fprintf(out, "    \"size\": %d,\n", settings.size);
+    fprintf(out, "    \"seed\": %u,\n", settings.seed);
+    fprintf(out, "    \"cave_lattice_step\": %d\n", settings.cave_lattice_step);
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"chunks\": %d,\n", num_chunks);
+    fprintf(out, "  \"graph_per_chunk\": {\"ms\": %.3f, \"chunks_per_sec\": %.1f},\n",
+        per_chunk.ms, get_chunks_per_sec(num_chunks, per_chunk.ms));
+    fprintf(out, "  \"graph_reused\": {\"ms\": %.3f, \"chunks_per_sec\": %.1f},\n", reused.ms,
+        get_chunks_per_sec(num_chunks, reused.ms));
+    fprintf(out, "  \"graph_build_ms_per_chunk\": %.4f,\n", graph_ms_per_chunk);
+    fprintf(out, "  \"generate_ms_per_chunk\": %.4f,\n", generate_ms_per_chunk);
+    fprintf(out, "  \"graph_build_share\": %.4f,\n",
+        per_chunk.ms > 0.0 ? per_chunk.graph_ms / per_chunk.ms : 0.0);
+    fprintf(out, "  \"passed\": %s\n", passed ? "true" : "false");
+    fprintf(out, "}\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+// Headless benchmarks of the CPU side of the engine: the voxel pipeline (terrain generation, mesh
+// snapshots and the mesher) and its parts. Doesn't create a window or a GL context, the results
+// are written as JSON. The exit code is non-zero if a check of the benchmark failed
+
+#include "Bench.h"
+
+#include "EngineGlobals.h"
+#include "threads/Threads.h"
+#include "time/Time.h"
+#include "voxels/Chunk.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace bench;
+
+namespace
+{
+
+struct BenchInfo
+{
+    const char *name;
+    int (*run)(const Settings &settings, FILE *out);
+};
+
+constexpr BenchInfo BENCHES[] = {
+    {"pipeline", run_pipeline},
+    {"noise", run_noise},
+    {"codec", run_codec},
+    {"jobs", run_jobs},
+    {"chunks_map", run_chunks_map},
+    {"terrain", run_terrain},
+    {"profiler", run_profiler},
+    {"task_graph", run_task_graph},
+};
+
+const BenchInfo *find_bench(const char *name)
+{
+    for (const BenchInfo &bench : BENCHES)
+    {
+        if (strcmp(bench.name, name) == 0)
+        {
+            return &bench;
+        }
+    }
+    return nullptr;
+}
+
+bool parse_args(int argc, char **argv, Settings &settings)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            return false;
+        }
+        ++i;
+
+        if (strcmp(arg, "--bench") == 0)
+        {
+            settings.bench = value;
+        }
+        else if (strcmp(arg, "--size") == 0)
+        {
+            settings.size = atoi(value);
+        }
+        else if (strcmp(arg, "--seed") == 0)
+        {
+            settings.seed = (unsigned int)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--threads") == 0)
+        {
+            settings.threads = atoi(value);
+        }
+        else if (strcmp(arg, "--cave-step") == 0)
+        {
+            settings.cave_lattice_step = atoi(value);
+        }
+        else if (strcmp(arg, "--mode") == 0)
+        {
+            if (strcmp(value, "greedy") == 0)
+            {
+                settings.mode = ChunkMeshGenerator::Mode::Greedy;
+            }
+            else if (strcmp(value, "naive") == 0)
+            {
+                settings.mode = ChunkMeshGenerator::Mode::Naive;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (strcmp(arg, "--output") == 0)
+        {
+            settings.output = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const int step = settings.cave_lattice_step;
+    return find_bench(settings.bench) && settings.size > 0 && settings.threads >= 0 && step >= 1
+        && step <= Chunk::CHUNK_WIDTH && (step & (step - 1)) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    if (!parse_args(argc, argv, settings))
+    {
+        fprintf(stderr, "Usage: realengine_bench [--bench");
+        for (const BenchInfo &bench : BENCHES)
+        {
+            fprintf(stderr, "%s%s", &bench == BENCHES ? " " : "|", bench.name);
+        }
+        fprintf(stderr,
+            "] [--size chunks] [--seed seed] [--threads count] [--mode greedy|naive] "
+            "[--cave-step 1|2|4|8|16] [--output file.json]\n");
+        return 1;
+    }
+
+    FILE *out = settings.output ? fopen(settings.output, "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "Can't open %s\n", settings.output);
+        return 1;
+    }
+
+    // The engine logs go to stderr, stdout is left for the results
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    // The job queue and the profiler need the main thread and the time
+    Threads::init();
+    Time time;
+    eng.time = &time;
+
+    const int result = find_bench(settings.bench)->run(settings, out);
+    eng.time = nullptr;
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return result;
+}
@@ -11,9 +11,10 @@
     #define REALENGINE_EXPORT
 #endif
 
-// TODO: for different compilers
-#if 1
+#if defined(_MSC_VER)
     #define REALENGINE_INLINE __forceinline
+#else
+    #define REALENGINE_INLINE inline __attribute__((always_inline))
 #endif
 
 #ifdef REALENGINE_LIBRARY
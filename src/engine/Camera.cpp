@@ -44,12 +44,13 @@ void Camera::update_cached()
     // clang-format off
     // https://stackoverflow.com/a/34960913/19031745
     // TODO: shitty?
-    for (int i = 4; i--; ) { planes_.left[i]   = viewproj_[i][3] + viewproj_[i][0]; }
-    for (int i = 4; i--; ) { planes_.right[i]  = viewproj_[i][3] - viewproj_[i][0]; }
-    for (int i = 4; i--; ) { planes_.bottom[i] = viewproj_[i][3] + viewproj_[i][1]; }
-    for (int i = 4; i--; ) { planes_.top[i]    = viewproj_[i][3] - viewproj_[i][1]; }
-    for (int i = 4; i--; ) { planes_.near[i]   = viewproj_[i][3] + viewproj_[i][2]; }
-    for (int i = 4; i--; ) { planes_.far[i]    = viewproj_[i][3] - viewproj_[i][2]; }
+    glm::vec4 *planes = planes_.planes;
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Left][i]   = viewproj_[i][3] + viewproj_[i][0]; }
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Right][i]  = viewproj_[i][3] - viewproj_[i][0]; }
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Bottom][i] = viewproj_[i][3] + viewproj_[i][1]; }
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Top][i]    = viewproj_[i][3] - viewproj_[i][1]; }
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Near][i]   = viewproj_[i][3] + viewproj_[i][2]; }
+    for (int i = 4; i--; ) { planes[FrustumPlanes::Far][i]    = viewproj_[i][3] - viewproj_[i][2]; }
     // clang-format on
 
     for (glm::vec4 &p : planes_.planes)
@@ -2,7 +2,7 @@
 
 #include "EngineGlobals.h"
 #include "Gui.h"
-#include "ImguiUtils.h"
+#include "ImGuiUtils.h"
 #include "MaterialManager.h"
 #include "MeshManager.h"
 #include "NodeMesh.h"
@@ -14,6 +14,8 @@
 #include "World.h"
 #include "input/Input.h"
 #include "math/Math.h"
+#include "profiler/ProfilerStats.h"
+#include "profiler/ScopedProfiler.h"
 #include "threads/JobQueue.h"
 #include "time/Time.h"
 #include "utils/Algos.h"
@@ -102,6 +104,7 @@ void Editor::load_configs()
     read(meshes_window_);
     read(info_window_);
     read(settings_window_);
+    read(profiler_window_);
 }
 
 void Editor::save_configs()
@@ -120,6 +123,7 @@ void Editor::save_configs()
     write(meshes_window_);
     write(info_window_);
     write(settings_window_);
+    write(profiler_window_);
 
     file.flush();
     file.close();
@@ -166,6 +170,7 @@ void Editor::render()
     render_shaders();
     render_meshes();
     render_info();
+    render_profiler();
     render_popup();
 
     visualize_selected_node();
@@ -195,6 +200,8 @@ void Editor::render_main()
     ImGui::SameLine(OFFSET);
     ImGui::Checkbox("World", &nodes_window_);
 
+    ImGui::Checkbox("Profiler", &profiler_window_);
+
     ImGui::End();
 }
 
@@ -374,7 +381,7 @@ void Editor::render_materials()
         constexpr ImVec2 RESET_BUTTON_SIZE(15, 19);
 
         const auto get_color = [&](bool is_writable) {
-            return is_writable ? OVERRIDE_COLOR : DEFAULT_TEXT_COLOR;
+            return is_writable ? (ImVec4)OVERRIDE_COLOR : DEFAULT_TEXT_COLOR;
         };
 
         ImGui::BeginGroup();
@@ -879,21 +886,119 @@ void Editor::render_info()
         ImGui::SeparatorText("Frame");
         ImGui::Text("Rendered Indices: %llu", eng.stat.getNumRenderedIndicesInFrame());
         ImGui::Text("Compiled Shaders: %llu", eng.stat.getNumCompiledShadersInFrame());
+        ImGui::Text("Uploaded: %.1f KB", eng.stat.getNumUploadedBytesInFrame() / 1024.0);
         ImGui::SeparatorText("Total");
         ImGui::Text("Rendered Indices: %llu", eng.stat.getNumRenderedIndicesTotal());
         ImGui::Text("Compiled Shaders: %llu", eng.stat.getNumCompiledShadersTotal());
+        ImGui::Text("Uploaded: %.1f MB", eng.stat.getNumUploadedBytesTotal() / (1024.0 * 1024.0));
         ImGui::SeparatorText("Voxel Engine");
         ImGui::Text("Render chunks: %llu", eng.stat.getNumRenderedChunksInFrame());
         ImGui::Text("Render vertices: %llu", eng.stat.getNumRenderChunksVerticesInFrame());
+        {
+            const uint64_t num_chunks = eng.stat.getNumLoadedChunks();
+            const uint64_t memory = eng.stat.getLoadedChunksMemory();
+            const double per_chunk_kb = num_chunks > 0 ? memory / 1024.0 / num_chunks : 0.0;
+            ImGui::Text("Loaded chunks: %llu", num_chunks);
+            ImGui::Text("Chunks memory: %.1f MB (%.1f KB/chunk)", memory / (1024.0 * 1024.0),
+                per_chunk_kb);
+        }
+        ImGui::Text("Chunk I/O queue: %llu", eng.stat.getChunkIOQueueDepth());
+        ImGui::Text("Chunk I/O read/write: %.2f/%.2f MB/s",
+            eng.stat.getChunkIOReadBytesPerSec() / (1024.0 * 1024.0),
+            eng.stat.getChunkIOWrittenBytesPerSec() / (1024.0 * 1024.0));
         ImGui::SeparatorText("Threads");
         ImGui::Text("Queued jobs: %d", eng.queue->getNumJobs());
         ImGui::Text("Threads busy/all: %d/%d", eng.queue->getNumBusyThreads(),
             eng.queue->getNumThreads());
+        ImGui::Text("Deferred finishes: %d", eng.queue->getNumDeferredFinishes());
+        ImGui::Text("Max finish latency: %.2f ms", eng.queue->getMaxFinishLatencyUsec() / 1000.0);
         ImGui::Separator();
     }
     ImGui::End();
 }
 
+void Editor::render_profiler()
+{
+    if (!profiler_window_)
+    {
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(900, 400), ImGuiCond_FirstUseEver);
+
+    if (!ImGui::Begin("Profiler", &profiler_window_))
+    {
+        ImGui::End();
+        return;
+    }
+
+    const ProfilerStats &stats = Profiler::getStats();
+    ImGui::Text("Frames: %llu, P95/P99 of the last %d", stats.getNumFrames(),
+        ProfilerStats::WINDOW_FRAMES);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        Profiler::resetStats();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save CSV"))
+    {
+        const char *path = "profiler_stats.csv";
+        std::string message = Profiler::dumpStatsCSV(path) ? "Profiler stats saved to "
+                                                            : "Can't save profiler stats to ";
+        message += path;
+        addPopup(message.c_str());
+    }
+    ImGui::SameLine();
+    profiler_filter_.Draw("Filter");
+
+    constexpr ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+        | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("##profiler stats", 10, flags))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Thread");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Total ms");
+        ImGui::TableSetupColumn("Self ms");
+        ImGui::TableSetupColumn("Min ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("P95 ms");
+        ImGui::TableSetupColumn("P99 ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        for (const ProfilerStats::Row &row : stats.getRows())
+        {
+            if (!profiler_filter_.PassFilter(row.name.c_str()))
+            {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.name.c_str());
+            if (ImGui::IsItemHovered())
+            {
+                ImGui::SetTooltip("%s", row.location.c_str());
+            }
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.thread_name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", row.calls);
+            for (const double value : {row.total_ms, row.self_ms, row.min_ms, row.avg_ms,
+                     row.p95_ms, row.p99_ms, row.max_ms})
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", value);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
 void Editor::render_popup()
 {
     const uint64_t cur_time_ms = eng.time->getTimeUsec() / 1000;
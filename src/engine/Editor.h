@@ -61,6 +61,7 @@ private:
     void render_shaders();
     void render_meshes();
     void render_info();
+    void render_profiler();
     void render_popup();
 
     void render_texture_info(Texture *texture);
@@ -112,6 +113,10 @@ private:
     // Settings
     bool settings_window_{true};
 
+    // Profiler
+    bool profiler_window_{false};
+    ImGuiTextFilter profiler_filter_;
+
     struct Mat4WidgetData
     {
         glm::vec3 pos{};
@@ -1,5 +1,7 @@
 #include "IndexBufferObject.h"
 
+#include "EngineGlobals.h"
+
 // clang-format off
 #include "glad/glad.h"
 // clang-format on
@@ -74,4 +76,5 @@ void IndexBufferObject::flush(bool dynamic)
     const int load_flag = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
     GL_CHECKED(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_));
     GL_CHECKED(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * INDEX_SIZE, indices_.data(), load_flag));
+    eng.stat.addUploadedBytes(indices_.size() * INDEX_SIZE);
 }
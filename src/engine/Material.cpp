@@ -21,8 +21,8 @@
         }                                                                                          \
         Parameter parameter;                                                                       \
         parameter.name = name;                                                                     \
-        parameter.type = ParameterType::##TYPE_NAME;                                               \
-        parameter.##UNION_ELEMENT##_value = value;                                                 \
+        parameter.type = ParameterType::TYPE_NAME;                                                 \
+        parameter.UNION_ELEMENT##_value = value;                                                   \
         const int i = base_.parameters.size();                                                     \
         base_.parameters.push_back(parameter);                                                     \
         return i;                                                                                  \
@@ -36,7 +36,7 @@
             std::cout << "Parameter not found: " << name << std::endl;                             \
             return;                                                                                \
         }                                                                                          \
-        if (getParameterType(index) != ParameterType::##TYPE_NAME)                                 \
+        if (getParameterType(index) != ParameterType::TYPE_NAME)                                   \
         {                                                                                          \
             std::cout << "Parameter type does not match: " << name << std::endl;                   \
             return;                                                                                \
@@ -46,7 +46,7 @@
                                                                                                    \
     void Material::setParameter##TYPE_NAME(int i, TYPE_VALUE_SET value)                            \
     {                                                                                              \
-        if (getParameterType(i) != ParameterType::##TYPE_NAME)                                     \
+        if (getParameterType(i) != ParameterType::TYPE_NAME)                                       \
         {                                                                                          \
             std::cout << "Parameter type does not match: " << i << std::endl;                      \
             return;                                                                                \
@@ -54,7 +54,7 @@
                                                                                                    \
         if (isBase())                                                                              \
         {                                                                                          \
-            auto &v = base_.parameters[i].##UNION_ELEMENT##_value;                                 \
+            auto &v = base_.parameters[i].UNION_ELEMENT##_value;                                   \
             if (v == value)                                                                        \
             {                                                                                      \
                 return;                                                                            \
@@ -69,7 +69,7 @@
         }                                                                                          \
         ParameterOverride &v = inherited_.parameters[i];                                           \
         v.override = true;                                                                         \
-        v.##UNION_ELEMENT##_value = value;                                                         \
+        v.UNION_ELEMENT##_value = value;                                                           \
     }                                                                                              \
                                                                                                    \
     TYPE_VALUE_GET Material::getParameter##TYPE_NAME(const char *name) const                       \
@@ -85,7 +85,7 @@
                                                                                                    \
     TYPE_VALUE_GET Material::getParameter##TYPE_NAME(int i) const                                  \
     {                                                                                              \
-        if (getParameterType(i) != ParameterType::##TYPE_NAME)                                     \
+        if (getParameterType(i) != ParameterType::TYPE_NAME)                                       \
         {                                                                                          \
             std::cout << "Parameter type does not match " << i << std::endl;                       \
             return DEFAULT_VALUE;                                                                  \
@@ -97,12 +97,12 @@
             const ParameterOverride &ov = cur->inherited_.parameters[i];                           \
             if (ov.override)                                                                       \
             {                                                                                      \
-                return ov.##UNION_ELEMENT##_value;                                                 \
+                return ov.UNION_ELEMENT##_value;                                                   \
             }                                                                                      \
             cur = cur->parent_mat_;                                                                \
         }                                                                                          \
         assert(cur == base_mat_);                                                                  \
-        return cur->base_.parameters[i].##UNION_ELEMENT##_value;                                   \
+        return cur->base_.parameters[i].UNION_ELEMENT##_value;                                     \
     }
 
 constexpr glm::vec4 DEFAULT_VEC4 = glm::vec4{0, 0, 0, 1};
@@ -1,6 +1,7 @@
 #include "Random.h"
 
 #include <chrono>
+#include <climits>
 #include <random>
 
 namespace
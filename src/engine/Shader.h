@@ -5,6 +5,7 @@
 #include "glm/fwd.hpp"
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 
 class ShaderSource;
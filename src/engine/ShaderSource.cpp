@@ -4,6 +4,9 @@
 #include "Shader.h"
 #include "fs/FileSystem.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace
 {
 
@@ -1,16 +1,26 @@
 #pragma once
 
+#include "profiler/ScopedProfiler.h"
+
 #include <cstdint>
 
 struct Statistics
 {
     void finishFrame()
     {
+        PROFILER_COUNTER("Rendered indices", num_rendered_indices_in_frame_);
+        PROFILER_COUNTER("Rendered chunks", vox.num_rendered_chunks_in_frame);
+        PROFILER_COUNTER("Rendered chunk vertices", vox.num_rendered_vertices_in_frame);
+        PROFILER_COUNTER("Uploaded bytes", num_uploaded_bytes_in_frame_);
+        PROFILER_COUNTER("Compiled shaders", num_compiled_shaders_in_frame_);
+
         num_compiled_shaders_total_ += num_compiled_shaders_in_frame_;
         num_rendered_indices_total_ += num_rendered_indices_in_frame_;
+        num_uploaded_bytes_total_ += num_uploaded_bytes_in_frame_;
 
         num_rendered_indices_in_frame_ = 0;
         num_compiled_shaders_in_frame_ = 0;
+        num_uploaded_bytes_in_frame_ = 0;
 
         vox.num_rendered_chunks_in_frame = 0;
         vox.num_rendered_vertices_in_frame = 0;
@@ -18,20 +28,37 @@ struct Statistics
 
     void addRenderedIndices(uint64_t count) { num_rendered_indices_in_frame_ += count; }
     void addCompiledShaders(uint64_t count) { num_compiled_shaders_in_frame_ += count; }
+    // Vertex and index buffer data sent to the GPU
+    void addUploadedBytes(uint64_t bytes) { num_uploaded_bytes_in_frame_ += bytes; }
 
     // Frame
     uint64_t getNumRenderedIndicesInFrame() const { return num_rendered_indices_in_frame_; }
     uint64_t getNumCompiledShadersInFrame() const { return num_compiled_shaders_in_frame_; }
+    uint64_t getNumUploadedBytesInFrame() const { return num_uploaded_bytes_in_frame_; }
 
     // Total
     uint64_t getNumRenderedIndicesTotal() const { return num_rendered_indices_total_; }
     uint64_t getNumCompiledShadersTotal() const { return num_compiled_shaders_total_; }
+    uint64_t getNumUploadedBytesTotal() const { return num_uploaded_bytes_total_; }
 
     ///////////////////////////////////////////
     // Voxel
     void addRenderedChunks(uint64_t count) { vox.num_rendered_chunks_in_frame += count; }
     void addRenderedChunksVertices(uint64_t count) { vox.num_rendered_vertices_in_frame += count; }
 
+    void setLoadedChunks(uint64_t count, uint64_t memory_bytes)
+    {
+        vox.num_loaded_chunks = count;
+        vox.loaded_chunks_memory = memory_bytes;
+    }
+
+    void setChunkIO(uint64_t queue_depth, double read_bytes_per_sec, double written_bytes_per_sec)
+    {
+        vox.io_queue_depth = queue_depth;
+        vox.io_read_bytes_per_sec = read_bytes_per_sec;
+        vox.io_written_bytes_per_sec = written_bytes_per_sec;
+    }
+
     // Frame
     uint64_t getNumRenderedChunksInFrame() const { return vox.num_rendered_chunks_in_frame; }
     uint64_t getNumRenderChunksVerticesInFrame() const
@@ -39,14 +66,23 @@ struct Statistics
         return vox.num_rendered_vertices_in_frame;
     }
 
+    // Current
+    uint64_t getNumLoadedChunks() const { return vox.num_loaded_chunks; }
+    uint64_t getLoadedChunksMemory() const { return vox.loaded_chunks_memory; }
+    uint64_t getChunkIOQueueDepth() const { return vox.io_queue_depth; }
+    double getChunkIOReadBytesPerSec() const { return vox.io_read_bytes_per_sec; }
+    double getChunkIOWrittenBytesPerSec() const { return vox.io_written_bytes_per_sec; }
+
 private:
     // Frame
     uint64_t num_rendered_indices_in_frame_{0};
     uint64_t num_compiled_shaders_in_frame_{0};
+    uint64_t num_uploaded_bytes_in_frame_{0};
 
     // Total
     uint64_t num_rendered_indices_total_{0};
     uint64_t num_compiled_shaders_total_{0};
+    uint64_t num_uploaded_bytes_total_{0};
 
     // Voxel
     struct
@@ -54,5 +90,12 @@ private:
         // Frame
         uint64_t num_rendered_chunks_in_frame{0};
         uint64_t num_rendered_vertices_in_frame{0};
+
+        // Current
+        uint64_t num_loaded_chunks{0};
+        uint64_t loaded_chunks_memory{0};
+        uint64_t io_queue_depth{0};
+        double io_read_bytes_per_sec{0.0};
+        double io_written_bytes_per_sec{0.0};
     } vox;
 };
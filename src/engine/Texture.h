@@ -48,6 +48,9 @@ public:
 
     struct LoadParams
     {
+        // GCC can't use the member initializers in the default arguments below without it
+        LoadParams() {}
+
         Format target_format = Format::RGBA;
         Wrap wrap = Wrap::Repeat;
         Filter min_filter = Filter::Linear;
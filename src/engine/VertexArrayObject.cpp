@@ -32,6 +32,16 @@ void VertexArrayObject::addAttributeFloat(int count)
     attributes_.push_back(attr);
 }
 
+void VertexArrayObject::addAttributeUint(int count)
+{
+    Attribute attr;
+    attr.count = count;
+    attr.size_of_type = sizeof(unsigned int);
+    attr.type = GL_UNSIGNED_INT;
+    attr.integer = true;
+    attributes_.push_back(attr);
+}
+
 void VertexArrayObject::clear()
 {
     attributes_.clear();
@@ -66,8 +76,16 @@ void VertexArrayObject::flush() const
     for (int i = 0; i < attributes_.size(); ++i)
     {
         const Attribute &attribute = attributes_[i];
-        GL_CHECKED(glVertexAttribPointer(i, attribute.count, attribute.type, GL_FALSE, stride,
-            reinterpret_cast<void *>(offset)));
+        if (attribute.integer)
+        {
+            GL_CHECKED(glVertexAttribIPointer(i, attribute.count, attribute.type, stride,
+                reinterpret_cast<void *>(offset)));
+        }
+        else
+        {
+            GL_CHECKED(glVertexAttribPointer(i, attribute.count, attribute.type, GL_FALSE, stride,
+                reinterpret_cast<void *>(offset)));
+        }
         GL_CHECKED(glEnableVertexAttribArray(i));
         offset += attribute.count * attribute.size_of_type;
     }
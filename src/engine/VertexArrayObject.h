@@ -15,6 +15,8 @@ public:
     ~VertexArrayObject();
 
     void addAttributeFloat(int count);
+    // Integer attribute, read as uint/uvecN in shaders without conversion to float
+    void addAttributeUint(int count);
 
     void clear();
 
@@ -28,6 +30,7 @@ private:
         int type{-1};
         int size_of_type{-1};
         int count{-1};
+        bool integer{false};
     };
     std::vector<Attribute> attributes_;
     unsigned int vao_{};
@@ -1,5 +1,7 @@
 #include "VertexBufferObject.h"
 
+#include "EngineGlobals.h"
+
 // clang-format off
 #include <glad/glad.h>
 // clang-format on
@@ -25,6 +27,7 @@ void VertexBufferObjectHelper::setBufferData(size_t size, const void *data, bool
 {
     const int load_flag = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
     GL_CHECKED(glBufferData(GL_ARRAY_BUFFER, size, data, load_flag));
+    eng.stat.addUploadedBytes(size);
 }
 
 void VertexBufferObjectHelper::unbindBuffer()
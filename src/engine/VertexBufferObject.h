@@ -2,6 +2,7 @@
 #include "Base.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -62,12 +63,6 @@ public:
 
     void clear() { vertices_.clear(); }
 
-    void deallocate()
-    {
-        vertices_.clear();
-        vertices_.shrink_to_fit();
-    }
-
     void bind() const
     {
         if (vbo_ == 0)
@@ -90,6 +85,19 @@ public:
         num_gpu_vertices = vertices_.size();
     }
 
+    // Upload the vertices stored outside of the buffer, the CPU vertices are not changed
+    void flush(const V *vertices, int num_vertices, bool dynamic = false)
+    {
+        if (vbo_ == 0)
+        {
+            std::cout << "VertexBufferObject::flush() - vbo_ == 0" << std::endl;
+            return;
+        }
+        bindBuffer(vbo_);
+        setBufferData(num_vertices * VERTEX_SIZE, vertices, dynamic);
+        num_gpu_vertices = num_vertices;
+    }
+
 private:
     static constexpr int VERTEX_SIZE = sizeof(V);
 
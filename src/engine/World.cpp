@@ -7,6 +7,7 @@
 #include <NodeMesh.h>
 
 #include <cassert>
+#include <climits>
 
 Node *World::findNodeByName(const char *name) const
 {
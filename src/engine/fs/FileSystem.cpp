@@ -1,8 +1,13 @@
 #include "FileSystem.h"
 
-#include <windows.h>
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
 
 #include <cassert>
+#include <climits>
 #include <filesystem>
 #include <fstream>
 
@@ -39,9 +44,13 @@ std::string FileSystem::toAbsolutePath(const char *path) const
 
 bool FileSystem::isAbsolutePath(const char *path)
 {
+#ifdef _WIN32
     // C:\blabla
     // TODO: shitty
     return std::isalpha(path[0]) && path[1] == ':' && path[2] == '\\';
+#else
+    return path[0] == '/';
+#endif
 }
 
 std::string FileSystem::readFile(const char *path)
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Base.h"
+
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+class REALENGINE_API MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    REMOVE_COPY_MOVE_CLASS(MappedFile);
+
+    // Returns false if the file doesn't exist or is empty
+    bool open(const char *path);
+    void close();
+
+    bool isOpen() const { return data_ != nullptr; }
+
+    const uint8_t *getData() const { return data_; }
+    uint64_t getSize() const { return size_; }
+
+private:
+    const uint8_t *data_{nullptr};
+    uint64_t size_{0};
+
+#ifdef _WIN32
+    void *file_{nullptr};
+    void *mapping_{nullptr};
+#endif
+};
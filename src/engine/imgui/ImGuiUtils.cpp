@@ -1,4 +1,4 @@
-#include "ImguiUtils.h"
+#include "ImGuiUtils.h"
 
 #include "imgui.h"
 
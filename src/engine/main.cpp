@@ -55,6 +55,8 @@
 
 const unsigned int DEFAULT_WIDTH = 1600;
 const unsigned int DEFAULT_HEIGHT = 900;
+// Main thread time for finishing the jobs in a frame
+const uint64_t FINISH_JOBS_BUDGET_USEC = 4000;
 
 class Engine
 {
@@ -265,6 +267,16 @@ public:
             {
                 eng.vox->setAmbientOcclusionEnabled(use_ao);
             }
+            bool greedy_meshing = eng.vox->isGreedyMeshingEnabled();
+            if (ImGui::Checkbox("Voxel Engine Greedy Meshing", &greedy_meshing))
+            {
+                eng.vox->setGreedyMeshingEnabled(greedy_meshing);
+            }
+            bool cave_interpolation = eng.vox->isCaveInterpolationEnabled();
+            if (ImGui::Checkbox("Voxel Engine Interpolated Caves", &cave_interpolation))
+            {
+                eng.vox->setCaveInterpolationEnabled(cave_interpolation);
+            }
 
             ImGui::DragInt("Erase radius intersection", &erase_radius_intersection, 0, 1, 60);
             ImGui::DragInt("Erase radius", &erase_radius_self, 0, 1, 60);
@@ -423,6 +435,7 @@ private:
         Random::init();
         eng.engine_ = this;
         eng.queue = new tbb::JobQueue();
+        eng.queue->setFinishBudgetUsec(FINISH_JOBS_BUDGET_USEC);
         eng.proxy = new SystemProxy();
         eng.input = new Input();
         eng.time = new Time();
@@ -507,6 +520,16 @@ private:
             edg.editor_->addPopup(message.c_str());
         }
 
+        if (eng.input->isKeyPressed(Key::KEY_F10))
+        {
+            const char *path = "profiler.json";
+            Profiler::dumpTrace(path);
+            std::string message = "Profiler trace saved to ";
+            message += path;
+            std::cout << message << std::endl;
+            edg.editor_->addPopup(message.c_str());
+        }
+
         if (eng.input->isKeyPressed(Key::KEY_F3))
         {
             eng.world->disableAll();
@@ -4,17 +4,16 @@
 
 struct FrustumPlanes
 {
-    union
+    enum Plane
     {
-        glm::vec4 planes[6];
-        struct
-        {
-            glm::vec4 left;
-            glm::vec4 right;
-            glm::vec4 bottom;
-            glm::vec4 top;
-            glm::vec4 near;
-            glm::vec4 far;
-        };
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        NumPlanes
     };
+
+    glm::vec4 planes[NumPlanes];
 };
\ No newline at end of file
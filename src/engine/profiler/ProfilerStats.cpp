@@ -0,0 +1,229 @@
+#include "ProfilerStats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <utility>
+
+namespace
+{
+
+int find_highest_bit(uint64_t value)
+{
+    assert(value != 0);
+    int bit = 0;
+    while (value >>= 1)
+    {
+        ++bit;
+    }
+    return bit;
+}
+
+std::string get_location(const ProbeSite &site)
+{
+    const char *file = site.file;
+    for (const char *c = site.file; *c; ++c)
+    {
+        if (*c == '/' || *c == '\\')
+        {
+            file = c + 1;
+        }
+    }
+    return std::string(file) + ':' + std::to_string(site.line);
+}
+
+void write_csv_string(std::ofstream &out, const std::string &str)
+{
+    out << '"';
+    for (const char c : str)
+    {
+        if (c == '"')
+        {
+            out << '"';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void ProfilerStats::setThreadName(uint64_t thread_id, const std::string &name)
+{
+    thread_names_[thread_id] = name;
+}
+
+void ProfilerStats::addScope(uint64_t thread_id, const ProbeSite *site, uint64_t duration,
+    uint64_t self_duration)
+{
+    Scope &scope = scopes_[Key{thread_id, site}];
+    if (scope.histogram.empty())
+    {
+        scope.histogram.resize(NUM_BUCKETS);
+    }
+    ++scope.calls;
+    scope.total += duration;
+    scope.self += self_duration;
+    scope.min = std::min(scope.min, duration);
+    scope.max = std::max(scope.max, duration);
+
+    const int bucket = get_bucket(duration);
+    ++scope.window_calls;
+    ++scope.histogram[bucket];
+    frame_samples_[frame_index_].push_back({&scope, bucket});
+}
+
+void ProfilerStats::addFrame()
+{
+    ++num_frames_;
+    frame_index_ = (frame_index_ + 1) % (WINDOW_FRAMES + 1);
+    std::vector<Sample> &samples = frame_samples_[frame_index_];
+    for (const Sample &sample : samples)
+    {
+        --sample.scope->window_calls;
+        --sample.scope->histogram[sample.bucket];
+    }
+    samples.clear();
+}
+
+void ProfilerStats::reset()
+{
+    num_frames_ = 0;
+    scopes_.clear();
+    for (std::vector<Sample> &samples : frame_samples_)
+    {
+        samples.clear();
+    }
+}
+
+std::vector<ProfilerStats::Row> ProfilerStats::getRows() const
+{
+    std::map<std::pair<uint64_t, std::string>, Scope> merged;
+    std::map<std::pair<uint64_t, std::string>, const ProbeSite *> first_sites;
+    for (const auto &it : scopes_)
+    {
+        const std::pair<uint64_t, std::string> key{it.first.thread_id, it.first.site->name};
+        merged[key].merge(it.second);
+        first_sites.emplace(key, it.first.site);
+    }
+
+    std::vector<Row> rows;
+    rows.reserve(merged.size());
+    for (const auto &it : merged)
+    {
+        const Scope &scope = it.second;
+        Row row;
+        row.name = it.first.second;
+        row.location = get_location(*first_sites[it.first]);
+        row.thread_id = it.first.first;
+        const auto name_it = thread_names_.find(row.thread_id);
+        row.thread_name = name_it != thread_names_.end() ? name_it->second
+                                                         : std::to_string(row.thread_id);
+        row.calls = scope.calls;
+        row.total_ms = to_ms(scope.total);
+        row.self_ms = to_ms(scope.self);
+        row.min_ms = to_ms(scope.min);
+        row.avg_ms = row.total_ms / scope.calls;
+        if (scope.window_calls > 0)
+        {
+            // Clamped, the bucket middle may be out of the seen values
+            row.p95_ms = to_ms(std::clamp(scope.getPercentile(0.95), scope.min, scope.max));
+            row.p99_ms = to_ms(std::clamp(scope.getPercentile(0.99), scope.min, scope.max));
+        }
+        row.max_ms = to_ms(scope.max);
+        rows.push_back(std::move(row));
+    }
+
+    std::sort(rows.begin(), rows.end(),
+        [](const Row &lhs, const Row &rhs) { return lhs.total_ms > rhs.total_ms; });
+    return rows;
+}
+
+bool ProfilerStats::dumpCSV(const char *path) const
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "scope,location,thread,calls,total_ms,self_ms,min_ms,avg_ms,p95_ms,p99_ms,max_ms,"
+           "frames,window_frames\n";
+    char buffer[256];
+    for (const Row &row : getRows())
+    {
+        write_csv_string(out, row.name);
+        out << ',';
+        write_csv_string(out, row.location);
+        out << ',';
+        write_csv_string(out, row.thread_name);
+        snprintf(buffer, sizeof(buffer), ",%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%llu,%d\n",
+            (unsigned long long)row.calls, row.total_ms, row.self_ms, row.min_ms, row.avg_ms,
+            row.p95_ms, row.p99_ms, row.max_ms, (unsigned long long)num_frames_, WINDOW_FRAMES);
+        out << buffer;
+    }
+    return true;
+}
+
+void ProfilerStats::Scope::merge(const Scope &other)
+{
+    if (histogram.empty())
+    {
+        histogram.resize(NUM_BUCKETS);
+    }
+    calls += other.calls;
+    total += other.total;
+    self += other.self;
+    window_calls += other.window_calls;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        histogram[i] += other.histogram[i];
+    }
+}
+
+uint64_t ProfilerStats::Scope::getPercentile(double fraction) const
+{
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(fraction * window_calls + 0.5));
+    uint64_t count = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i)
+    {
+        count += histogram[i];
+        if (count >= rank)
+        {
+            return get_bucket_middle(i);
+        }
+    }
+    return max;
+}
+
+int ProfilerStats::get_bucket(uint64_t value)
+{
+    if (value < NUM_SUB_BUCKETS)
+    {
+        return value;
+    }
+    const int bit = find_highest_bit(value);
+    const int sub_bucket = (value >> (bit - SUB_BUCKET_BITS)) & (NUM_SUB_BUCKETS - 1);
+    return (bit - SUB_BUCKET_BITS + 1) * NUM_SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t ProfilerStats::get_bucket_middle(int bucket)
+{
+    if (bucket < NUM_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const int bit = bucket / NUM_SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % NUM_SUB_BUCKETS;
+    const uint64_t width = uint64_t(1) << (bit - SUB_BUCKET_BITS);
+    const uint64_t begin = (uint64_t(1) << bit) + sub_bucket * width;
+    return begin + width / 2;
+}
+
+double ProfilerStats::to_ms(uint64_t ticks) const
+{
+    return (double)ticks * 1000.0 / (double)ticks_per_sec_;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Base.h"
+#include "ScopedProfiler.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Durations of the profiler scopes aggregated by the scope name and the thread. The percentiles
+// are taken from a log-linear histogram of the last WINDOW_FRAMES frames, the error is within 1/8
+// of the value. The other values are since the last reset
+class ProfilerStats
+{
+public:
+    // About 5 seconds at 60 fps, a spike stays in p99 until it leaves the window
+    static constexpr int WINDOW_FRAMES = 300;
+
+    struct Row
+    {
+        std::string name;
+        std::string location; // file:line of the first site with the name
+        std::string thread_name;
+        uint64_t thread_id{0};
+        uint64_t calls{0};
+        double total_ms{0.0};
+        double self_ms{0.0}; // without the nested scopes
+        double min_ms{0.0};
+        double avg_ms{0.0};
+        double p95_ms{0.0}; // 0 if not called in the window
+        double p99_ms{0.0};
+        double max_ms{0.0};
+    };
+
+    void setFrequency(uint64_t ticks_per_sec) { ticks_per_sec_ = ticks_per_sec; }
+    void setThreadName(uint64_t thread_id, const std::string &name);
+
+    // Durations in the profiler ticks
+    void addScope(uint64_t thread_id, const ProbeSite *site, uint64_t duration,
+        uint64_t self_duration);
+    // Drops the histogram samples of the frame leaving the window
+    void addFrame();
+
+    void reset();
+
+    uint64_t getNumFrames() const { return num_frames_; }
+    // The scopes with the same name are merged, sorted by the total time
+    std::vector<Row> getRows() const;
+
+    bool dumpCSV(const char *path) const;
+
+private:
+    // 8 sub-buckets for each power of 2
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int NUM_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * NUM_SUB_BUCKETS;
+
+    struct Scope
+    {
+        uint64_t calls{0};
+        uint64_t total{0};
+        uint64_t self{0};
+        uint64_t min{UINT64_MAX};
+        uint64_t max{0};
+        // Of the window frames
+        uint64_t window_calls{0};
+        std::vector<uint32_t> histogram;
+
+        void merge(const Scope &other);
+        uint64_t getPercentile(double fraction) const;
+    };
+
+    struct Key
+    {
+        uint64_t thread_id;
+        const ProbeSite *site;
+
+        bool operator==(const Key &other) const
+        {
+            return thread_id == other.thread_id && site == other.site;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            const size_t site_hash = std::hash<const void *>()(key.site);
+            return site_hash ^ (std::hash<uint64_t>()(key.thread_id) << 1);
+        }
+    };
+
+    // Taken back from the histogram once the frame leaves the window
+    struct Sample
+    {
+        Scope *scope;
+        int bucket;
+    };
+
+    static int get_bucket(uint64_t value);
+    static uint64_t get_bucket_middle(int bucket);
+
+    double to_ms(uint64_t ticks) const;
+
+private:
+    uint64_t ticks_per_sec_{1};
+    uint64_t num_frames_{0};
+    // The same name may be used by several sites, they are merged by getRows()
+    std::unordered_map<Key, Scope, KeyHash> scopes_;
+    std::unordered_map<uint64_t, std::string> thread_names_;
+    // Ring of the window frames and the current one
+    std::vector<Sample> frame_samples_[WINDOW_FRAMES + 1];
+    int frame_index_{0};
+};
@@ -1,22 +1,38 @@
 #include "ScopedProfiler.h"
 
 #include "EngineGlobals.h"
+#include "ProfilerStats.h"
 #include "fs/FileSystem.h"
 #include "threads/Threads.h"
 
 #include <immintrin.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
     #include <Windows.h>
+#else
+    #include <time.h>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #define REALENGINE_PROFILER_TSC
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+        #include <x86intrin.h>
+    #endif
 #endif
 
 #undef min
@@ -26,49 +42,97 @@ namespace
 {
 
 uint64_t get_perf_counter();
-uint64_t get_perf_frequency();
+// Selects the clock, returns its ticks per second
+uint64_t init_perf_clock();
 
 void dump_svg();
 void dump_html();
+void dump_trace();
 
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-ScopedProfiler::ScopedProfiler(const char *name)
+namespace
 {
-    Profiler::enterFunction(name, get_perf_counter());
-}
 
-ScopedProfiler::~ScopedProfiler()
+struct ProbeInfo
 {
-    Profiler::leaveFunction(get_perf_counter());
-}
+    const char *name; // valid - enterFunction, nullptr - leaveFunction
+    uint64_t time;
+};
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+// Written by the owner thread only, the fields are atomic for the dump reading the buffer
+// concurrently. The slots being overwritten during the read are dropped by copy_ring()
+struct Probe
+{
+    std::atomic<const ProbeSite *> site{nullptr}; // valid - enterFunction, nullptr - leaveFunction
+    std::atomic<uint64_t> time{0};
+};
+static_assert(sizeof(Probe) == 16);
 
-namespace
+struct CounterInfo
 {
+    const char *name;
+    uint64_t time;
+    double value;
+};
 
-struct ProbeInfo
+// Same access pattern as Probe
+struct CounterSample
+{
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> time{0};
+    std::atomic<double> value{0.0};
+};
+
+// Must be a power of 2
+constexpr uint64_t PROBES_PER_THREAD = 1 << 17;
+
+// A few dozens of samples per frame are expected, must be a power of 2
+constexpr uint64_t COUNTERS_PER_THREAD = 1 << 13;
+
+// Ring buffer of the last probes of one thread. Registered on the first probe of the thread and
+// kept after the thread exits, so its probes can still be dumped
+struct ThreadProbes
 {
-    ProbeInfo(const char *name, uint64_t time, uint64_t thread_id)
-        : name(name)
-        , time(time)
-        , thread_id(thread_id)
+    explicit ThreadProbes(uint64_t thread_id)
+        : thread_id(thread_id)
+        , probes(std::make_unique<Probe[]>(PROBES_PER_THREAD))
+        , counters(std::make_unique<CounterSample[]>(COUNTERS_PER_THREAD))
     {}
 
-    const char *name; // valid - enterFunction, nullptr - leaveFunction
-    uint64_t time;
-    uint64_t thread_id;
+    const uint64_t thread_id;
+    std::string name; // guarded by threads_mutex
+    std::unique_ptr<Probe[]> probes;
+    std::atomic<uint64_t> num_written{0};
+    std::unique_ptr<CounterSample[]> counters;
+    std::atomic<uint64_t> num_counters_written{0};
+
+    // Main thread only, the stats aggregation state
+    struct OpenScope
+    {
+        const ProbeSite *site;
+        uint64_t start;
+        uint64_t children; // duration of the nested scopes
+    };
+    uint64_t num_aggregated{0};
+    std::vector<OpenScope> open_scopes;
 };
 
+struct ThreadProbesCopy
+{
+    uint64_t thread_id;
+    std::string name;
+    std::vector<ProbeInfo> probes;
+};
 
 enum DumpType
 {
     DUMP_TYPE_NONE = 0,
     DUMP_TYPE_SVG = 1 << 0,
     DUMP_TYPE_HTML = 1 << 1,
+    DUMP_TYPE_TRACE = 1 << 2,
 };
 
 int REQUESTED_DUMP{DUMP_TYPE_NONE};
@@ -76,43 +140,271 @@ std::string DUMP_PATH{};
 
 uint64_t PERF_FREQ{};
 
-int HALF_MAX_RECORDED_FRAMES{100};
-int CUR_RECORDED_FRAMES{};
+// Main thread only. The dumps contain the probes since the oldest recorded frame
+std::vector<uint64_t> FRAME_BEGIN_TIMES(200, 0);
+uint64_t NUM_FRAMES{0};
+
+ProfilerStats STATS; // main thread only
+
+std::mutex threads_mutex; // registration of the threads and the dumps
+std::vector<UPtr<ThreadProbes>> THREAD_PROBES;
+thread_local ThreadProbes *t_probes = nullptr;
+
+ThreadProbes &register_thread_probes()
+{
+    std::scoped_lock lock(threads_mutex);
+    THREAD_PROBES.push_back(makeU<ThreadProbes>(Threads::getCurrentThreadId()));
+    t_probes = THREAD_PROBES.back().get();
+    return *t_probes;
+}
+
+// The registration is kept out of the probes' path, only the first probe of a thread takes it
+REALENGINE_INLINE ThreadProbes &get_thread_probes()
+{
+    return t_probes ? *t_probes : register_thread_probes();
+}
+
+REALENGINE_INLINE void add_probe(const ProbeSite *site, uint64_t time)
+{
+    ThreadProbes &thread_probes = get_thread_probes();
+    const uint64_t index = thread_probes.num_written.load(std::memory_order_relaxed);
+    Probe &probe = thread_probes.probes[index & (PROBES_PER_THREAD - 1)];
+    // For copy_ring(), no instruction on x86
+    std::atomic_thread_fence(std::memory_order_release);
+    probe.site.store(site, std::memory_order_relaxed);
+    probe.time.store(time, std::memory_order_relaxed);
+    thread_probes.num_written.store(index + 1, std::memory_order_release);
+}
+
+void add_counter(const char *name, double value, uint64_t time)
+{
+    ThreadProbes &thread_probes = get_thread_probes();
+    const uint64_t index = thread_probes.num_counters_written.load(std::memory_order_relaxed);
+    CounterSample &sample = thread_probes.counters[index & (COUNTERS_PER_THREAD - 1)];
+    std::atomic_thread_fence(std::memory_order_release);
+    sample.name.store(name, std::memory_order_relaxed);
+    sample.time.store(time, std::memory_order_relaxed);
+    sample.value.store(value, std::memory_order_relaxed);
+    thread_probes.num_counters_written.store(index + 1, std::memory_order_release);
+}
+
+uint64_t get_recorded_start_time()
+{
+    if (NUM_FRAMES == 0)
+    {
+        return 0;
+    }
+    const uint64_t num_recorded = std::min<uint64_t>(NUM_FRAMES, FRAME_BEGIN_TIMES.size());
+    return FRAME_BEGIN_TIMES[(NUM_FRAMES - num_recorded) % FRAME_BEGIN_TIMES.size()];
+}
+
+// Copies the slots [begin, end) of a ring buffer while its owner thread keeps writing to it, the
+// oldest ones may be overwritten meanwhile. As in a seqlock, num_written is read again after the
+// copy. The writer fences before each slot, so a slot read overwritten means num_written is at
+// least its index. Returns the first copied index which is certainly intact
+template <typename T, typename ReadSlot>
+uint64_t copy_ring(const std::atomic<uint64_t> &num_written, uint64_t capacity, uint64_t begin,
+    uint64_t end, std::vector<T> &out, const ReadSlot &read_slot)
+{
+    out.clear();
+    out.reserve(end - begin);
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        out.push_back(read_slot(i & (capacity - 1)));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t written = num_written.load(std::memory_order_relaxed);
+    // The slot of the index being written may be partially overwritten already
+    const uint64_t first_intact = written >= capacity ? written - capacity + 1 : 0;
+    return std::clamp(first_intact, begin, end);
+}
+
+ProbeInfo read_probe(const Probe &probe)
+{
+    const ProbeSite *site = probe.site.load(std::memory_order_relaxed);
+    return {site ? site->name : nullptr, probe.time.load(std::memory_order_relaxed)};
+}
+
+// Copies the probes of all the threads since start_time
+std::vector<ThreadProbesCopy> copy_probes(uint64_t start_time)
+{
+    std::scoped_lock lock(threads_mutex);
+
+    std::vector<ThreadProbesCopy> copies;
+    std::vector<ProbeInfo> probes;
+    for (const UPtr<ThreadProbes> &thread_probes : THREAD_PROBES)
+    {
+        const uint64_t end = thread_probes->num_written.load(std::memory_order_acquire);
+        const uint64_t begin = end > PROBES_PER_THREAD ? end - PROBES_PER_THREAD : 0;
+        const uint64_t first_intact = copy_ring(thread_probes->num_written, PROBES_PER_THREAD,
+            begin, end, probes,
+            [&](uint64_t slot) { return read_probe(thread_probes->probes[slot]); });
+
+        ThreadProbesCopy copy;
+        copy.thread_id = thread_probes->thread_id;
+        copy.name = thread_probes->name;
+        copy.probes.reserve(end - first_intact);
+        for (uint64_t i = first_intact; i < end; ++i)
+        {
+            const ProbeInfo &probe = probes[i - begin];
+            if (probe.time >= start_time)
+            {
+                copy.probes.push_back(probe);
+            }
+        }
+        if (!copy.probes.empty())
+        {
+            copies.push_back(std::move(copy));
+        }
+    }
+    return copies;
+}
+
+// Counter samples of all the threads since start_time, ordered by the time
+std::vector<CounterInfo> copy_counters(uint64_t start_time)
+{
+    std::vector<CounterInfo> counters;
+    {
+        std::scoped_lock lock(threads_mutex);
+        std::vector<CounterInfo> samples;
+        for (const UPtr<ThreadProbes> &thread_probes : THREAD_PROBES)
+        {
+            const uint64_t end =
+                thread_probes->num_counters_written.load(std::memory_order_acquire);
+            const uint64_t begin = end > COUNTERS_PER_THREAD ? end - COUNTERS_PER_THREAD : 0;
+            const uint64_t first_intact = copy_ring(thread_probes->num_counters_written,
+                COUNTERS_PER_THREAD, begin, end, samples, [&](uint64_t slot) {
+                    const CounterSample &sample = thread_probes->counters[slot];
+                    return CounterInfo{sample.name.load(std::memory_order_relaxed),
+                        sample.time.load(std::memory_order_relaxed),
+                        sample.value.load(std::memory_order_relaxed)};
+                });
+            for (uint64_t i = first_intact; i < end; ++i)
+            {
+                if (samples[i - begin].time >= start_time)
+                {
+                    counters.push_back(samples[i - begin]);
+                }
+            }
+        }
+    }
+    std::stable_sort(counters.begin(), counters.end(),
+        [](const CounterInfo &lhs, const CounterInfo &rhs) { return lhs.time < rhs.time; });
+    return counters;
+}
+
+// Aggregates the probes written since the previous call
+void update_stats()
+{
+    std::vector<ThreadProbes *> threads;
+    {
+        std::scoped_lock lock(threads_mutex);
+        for (const UPtr<ThreadProbes> &thread_probes : THREAD_PROBES)
+        {
+            threads.push_back(thread_probes.get());
+            if (!thread_probes->name.empty())
+            {
+                STATS.setThreadName(thread_probes->thread_id, thread_probes->name);
+            }
+            else if (thread_probes->thread_id == Threads::getMainThreadId())
+            {
+                STATS.setThreadName(thread_probes->thread_id, "Main");
+            }
+        }
+    }
+
+    struct ProbeCopy
+    {
+        const ProbeSite *site;
+        uint64_t time;
+    };
+    std::vector<ProbeCopy> probes;
+    for (ThreadProbes *thread_probes : threads)
+    {
+        const uint64_t end = thread_probes->num_written.load(std::memory_order_acquire);
+        const uint64_t begin = std::max(thread_probes->num_aggregated,
+            end > PROBES_PER_THREAD ? end - PROBES_PER_THREAD : 0);
+        const uint64_t first_intact = copy_ring(thread_probes->num_written, PROBES_PER_THREAD,
+            begin, end, probes, [&](uint64_t slot) {
+                const Probe &probe = thread_probes->probes[slot];
+                return ProbeCopy{probe.site.load(std::memory_order_relaxed),
+                    probe.time.load(std::memory_order_relaxed)};
+            });
+        if (first_intact != thread_probes->num_aggregated)
+        {
+            // Overwritten before aggregated, the open scopes can't be matched anymore
+            thread_probes->open_scopes.clear();
+        }
 
-std::mutex probes_mutex;
-std::vector<ProbeInfo> OLD_PROBES;
-std::vector<ProbeInfo> PROBES;
+        std::vector<ThreadProbes::OpenScope> &open_scopes = thread_probes->open_scopes;
+        for (uint64_t i = first_intact; i < end; ++i)
+        {
+            const ProbeSite *site = probes[i - begin].site;
+            const uint64_t time = probes[i - begin].time;
+            if (site)
+            {
+                open_scopes.push_back({site, time, 0});
+            }
+            else if (!open_scopes.empty())
+            {
+                const ThreadProbes::OpenScope scope = open_scopes.back();
+                open_scopes.pop_back();
+                const uint64_t duration = time - scope.start;
+                if (!open_scopes.empty())
+                {
+                    open_scopes.back().children += duration;
+                }
+                STATS.addScope(thread_probes->thread_id, scope.site, duration,
+                    duration - std::min(duration, scope.children));
+            }
+        }
+        thread_probes->num_aggregated = end;
+    }
+}
 
 } // namespace
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Both probes are written here directly, a scope is two clock reads and two ring buffer writes
+ScopedProfiler::ScopedProfiler(const ProbeSite *site)
+{
+    add_probe(site, get_perf_counter());
+}
+
+ScopedProfiler::~ScopedProfiler()
+{
+    add_probe(nullptr, get_perf_counter());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Profiler::init()
 {
-    PERF_FREQ = get_perf_frequency();
+    PERF_FREQ = init_perf_clock();
+    STATS.setFrequency(PERF_FREQ);
 }
 
 void Profiler::setMaxRecordedFrames(int frames)
 {
-    // TODO# shitty but i don't care
-    HALF_MAX_RECORDED_FRAMES = 1 + frames / 2;
+    FRAME_BEGIN_TIMES.assign(std::max(frames, 1), 0);
+    NUM_FRAMES = 0;
 }
 
-void Profiler::enterFunction(const char *name, uint64_t time)
+void Profiler::enterFunction(const ProbeSite *site, uint64_t time)
 {
-    const uint64_t thread_id = Threads::getCurrentThreadId();
-    std::scoped_lock lock(probes_mutex);
-    PROBES.emplace_back(name, time, thread_id);
+    add_probe(site, time);
 }
 
 void Profiler::leaveFunction(uint64_t time)
 {
-    const uint64_t thread_id = Threads::getCurrentThreadId();
-    std::scoped_lock lock(probes_mutex);
-    PROBES.emplace_back(nullptr, time, thread_id);
+    add_probe(nullptr, time);
 }
 
-void Profiler::enterFunction(const char *name)
+void Profiler::enterFunction(const ProbeSite *site)
 {
-    enterFunction(name, get_perf_counter());
+    enterFunction(site, get_perf_counter());
 }
 
 void Profiler::leaveFunction()
@@ -120,15 +412,39 @@ void Profiler::leaveFunction()
     leaveFunction(get_perf_counter());
 }
 
+uint64_t Profiler::getTicks()
+{
+    return get_perf_counter();
+}
+
+void Profiler::counter(const char *name, double value)
+{
+    add_counter(name, value, get_perf_counter());
+}
+
+void Profiler::setThreadName(const char *name)
+{
+    ThreadProbes &thread_probes = get_thread_probes();
+    std::scoped_lock lock(threads_mutex);
+    thread_probes.name = name;
+}
+
 void Profiler::beginFrame()
 {
-    enterFunction("Frame Total", get_perf_counter());
+    const uint64_t time = get_perf_counter();
+    FRAME_BEGIN_TIMES[NUM_FRAMES % FRAME_BEGIN_TIMES.size()] = time;
+    ++NUM_FRAMES;
+    static constexpr ProbeSite site{"Frame Total", __FILE__, __LINE__};
+    enterFunction(&site, time);
 }
 
 void Profiler::endFrame()
 {
     leaveFunction(get_perf_counter());
 
+    update_stats();
+    STATS.addFrame();
+
     if (REQUESTED_DUMP & DUMP_TYPE_SVG)
     {
         dump_svg();
@@ -139,25 +455,10 @@ void Profiler::endFrame()
         dump_html();
         REQUESTED_DUMP = REQUESTED_DUMP & (~DUMP_TYPE_HTML);
     }
-
-    std::scoped_lock lock(probes_mutex); // TODO! SHIT
-
-    ++CUR_RECORDED_FRAMES;
-    if (CUR_RECORDED_FRAMES > HALF_MAX_RECORDED_FRAMES)
+    else if (REQUESTED_DUMP & DUMP_TYPE_TRACE)
     {
-        CUR_RECORDED_FRAMES = 0;
-
-        const int size = PROBES.size();
-        const int capacity = PROBES.capacity();
-        if (capacity < size * 2)
-        {
-            PROBES.reserve(size * 3);
-            OLD_PROBES.reserve(size * 3);
-        }
-
-        // don't use std::move! otherwise a deallocation will happen
-        std::swap(OLD_PROBES, PROBES);
-        PROBES.clear();
+        dump_trace();
+        REQUESTED_DUMP = REQUESTED_DUMP & (~DUMP_TYPE_TRACE);
     }
 }
 
@@ -173,46 +474,137 @@ void Profiler::dumpHTML(const char *path)
     REQUESTED_DUMP = REQUESTED_DUMP | DUMP_TYPE_HTML ;
 }
 
+void Profiler::dumpTrace(const char *path)
+{
+    DUMP_PATH = path;
+    REQUESTED_DUMP = REQUESTED_DUMP | DUMP_TYPE_TRACE;
+}
+
+const ProfilerStats &Profiler::getStats()
+{
+    return STATS;
+}
+
+void Profiler::resetStats()
+{
+    STATS.reset();
+}
+
+bool Profiler::dumpStatsCSV(const char *path)
+{
+    return STATS.dumpCSV(path);
+}
+
 namespace
 {
 
-uint64_t get_perf_counter()
+// Spent in Profiler::init() to measure the TSC frequency
+constexpr double TSC_CALIBRATION_SEC = 0.02;
+
+// Set once by init_perf_clock() before the worker threads are started
+bool USE_TSC{false};
+
+uint64_t get_os_counter()
 {
 #ifdef _WIN32
     LARGE_INTEGER val;
     QueryPerformanceCounter(&val);
     return val.QuadPart;
 #else
-    static_assert(0, "Not implemented");
-    return 0;
+    timespec val;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &val);
+    return (uint64_t)val.tv_sec * 1'000'000'000 + val.tv_nsec;
 #endif
 }
 
-uint64_t get_perf_frequency()
+uint64_t get_os_frequency()
 {
 #ifdef _WIN32
     LARGE_INTEGER val;
     QueryPerformanceFrequency(&val);
     return val.QuadPart;
 #else
-    static_assert(0, "Not implemented");
-    return 0;
+    return 1'000'000'000;
+#endif
+}
+
+uint64_t get_perf_counter()
+{
+#ifdef REALENGINE_PROFILER_TSC
+    if (USE_TSC)
+    {
+        return __rdtsc();
+    }
+#endif
+    return get_os_counter();
+}
+
+#ifdef REALENGINE_PROFILER_TSC
+// Constant rate in all the power states, synchronized between the cores
+bool has_invariant_tsc()
+{
+    unsigned int regs[4]{};
+    #ifdef _MSC_VER
+    __cpuid(reinterpret_cast<int *>(regs), 0x80000000);
+    if (regs[0] < 0x80000007)
+    {
+        return false;
+    }
+    __cpuid(reinterpret_cast<int *>(regs), 0x80000007);
+    #else
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+    {
+        return false;
+    }
+    __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+    #endif
+    return (regs[3] & (1 << 8)) != 0;
+}
 #endif
+
+uint64_t init_perf_clock()
+{
+    const uint64_t os_frequency = get_os_frequency();
+#ifdef REALENGINE_PROFILER_TSC
+    if (has_invariant_tsc())
+    {
+        const uint64_t calibration_ticks = (uint64_t)(TSC_CALIBRATION_SEC * os_frequency);
+        const uint64_t os_begin = get_os_counter();
+        const uint64_t tsc_begin = __rdtsc();
+        uint64_t os_end = os_begin;
+        while (os_end - os_begin < calibration_ticks)
+        {
+            os_end = get_os_counter();
+        }
+        const uint64_t tsc_end = __rdtsc();
+
+        const double tsc_frequency =
+            (double)(tsc_end - tsc_begin) * (double)os_frequency / (double)(os_end - os_begin);
+        USE_TSC = true;
+        std::cout << "Profiler: TSC clock, " << tsc_frequency / 1e6 << " MHz" << std::endl;
+        return (uint64_t)tsc_frequency;
+    }
+#endif
+    std::cout << "Profiler: OS clock" << std::endl;
+    return os_frequency;
 }
 
 char TEMP_BUFFER[2048];
 
 void dump_svg()
 {
-    std::scoped_lock lock(probes_mutex); // TODO! SHIT
-
-    if (OLD_PROBES.empty() && PROBES.empty())
+    // The blocks of the threads would overlap, only the main thread is drawn
+    const std::vector<ThreadProbesCopy> copies = copy_probes(get_recorded_start_time());
+    const auto main_it = std::find_if(copies.begin(), copies.end(),
+        [](const ThreadProbesCopy &copy) { return copy.thread_id == Threads::getMainThreadId(); });
+    if (main_it == copies.end())
     {
         return;
     }
+    const std::vector<ProbeInfo> &probes = main_it->probes;
 
-    const uint64_t start_time = !OLD_PROBES.empty() ? OLD_PROBES[0].time : PROBES[0].time;
-    const uint64_t end_time = !PROBES.empty() ? PROBES.back().time : OLD_PROBES.back().time;
+    const uint64_t start_time = probes.front().time;
+    const uint64_t end_time = probes.back().time;
 
     std::ofstream out(DUMP_PATH);
 
@@ -240,9 +632,8 @@ void dump_svg()
             }
             stack.push_back(block);
         }
-        else
+        else if (!stack.empty())
         {
-            assert(!stack.empty());
             Block &block = stack.back();
             block.end = time - start_time;
             final_blocks.push_back(block);
@@ -250,11 +641,7 @@ void dump_svg()
         }
     };
 
-    for (const auto &probe : OLD_PROBES)
-    {
-        add_probe(probe.name, probe.time);
-    }
-    for (const auto &probe : PROBES)
+    for (const ProbeInfo &probe : probes)
     {
         add_probe(probe.name, probe.time);
     }
@@ -323,15 +710,17 @@ void dump_svg()
 
 void dump_html()
 {
-    std::scoped_lock lock(probes_mutex); // TODO! SHIT
-
-    if (OLD_PROBES.empty() && PROBES.empty())
+    const std::vector<ThreadProbesCopy> copies = copy_probes(get_recorded_start_time());
+    if (copies.empty())
     {
         return;
     }
 
-    const uint64_t start_time = !OLD_PROBES.empty() ? OLD_PROBES[0].time : PROBES[0].time;
-    const uint64_t end_time = !PROBES.empty() ? PROBES.back().time : OLD_PROBES.back().time;
+    uint64_t start_time = UINT64_MAX;
+    for (const ThreadProbesCopy &copy : copies)
+    {
+        start_time = std::min(start_time, copy.probes.front().time);
+    }
 
     std::ofstream out(DUMP_PATH, std::ios::binary);
 
@@ -388,13 +777,12 @@ void dump_html()
         }
     };
 
-    for (const auto &probe : OLD_PROBES)
-    {
-        add_probe(probe.name, probe.time, probe.thread_id);
-    }
-    for (const auto &probe : PROBES)
+    for (const ThreadProbesCopy &copy : copies)
     {
-        add_probe(probe.name, probe.time, probe.thread_id);
+        for (const ProbeInfo &probe : copy.probes)
+        {
+            add_probe(probe.name, probe.time, copy.thread_id);
+        }
     }
 
     // TODO: stupid but i don't care
@@ -457,5 +845,171 @@ void dump_html()
         template_content.size() - after_placeholder);
 }
 
+// Chrome Trace Event format, opened by chrome://tracing, ui.perfetto.dev and speedscope. The events
+// are written to the file as they are generated
+class TraceWriter
+{
+public:
+    TraceWriter(const char *path, uint64_t start_time)
+        : out_(path, std::ios::binary)
+        , start_time_(start_time)
+    {
+        out_ << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    }
+
+    ~TraceWriter() { out_ << "\n]}\n"; }
+
+    bool isOpen() const { return out_.is_open(); }
+
+    void writeThreadName(uint64_t thread_id, const std::string &name)
+    {
+        begin_event("thread_name", 'M', thread_id);
+        out_ << ",\"args\":{\"name\":";
+        write_string(name.c_str());
+        out_ << "}}";
+    }
+
+    void writeSlice(const char *name, char phase, uint64_t thread_id, uint64_t time)
+    {
+        begin_event(name, phase, thread_id);
+        write_time(time);
+        out_ << '}';
+    }
+
+    void writeFrameMarker(uint64_t thread_id, uint64_t time)
+    {
+        begin_event("Frame", 'i', thread_id);
+        write_time(time);
+        out_ << ",\"s\":\"g\"}";
+    }
+
+    void writeCounter(const char *name, uint64_t time, double value)
+    {
+        begin_event(name, 'C', 0);
+        write_time(time);
+        snprintf(TEMP_BUFFER, sizeof(TEMP_BUFFER), ",\"args\":{\"value\":%.3f}}", value);
+        out_ << TEMP_BUFFER;
+    }
+
+private:
+    void begin_event(const char *name, char phase, uint64_t thread_id)
+    {
+        if (!first_event_)
+        {
+            out_ << ",\n";
+        }
+        first_event_ = false;
+        out_ << "{\"name\":";
+        write_string(name);
+        snprintf(TEMP_BUFFER, sizeof(TEMP_BUFFER), ",\"ph\":\"%c\",\"pid\":1,\"tid\":%llu", phase,
+            (unsigned long long)thread_id);
+        out_ << TEMP_BUFFER;
+    }
+
+    void write_time(uint64_t time)
+    {
+        const double time_us = (double)(time - start_time_) * 1'000'000.0 / (double)PERF_FREQ;
+        snprintf(TEMP_BUFFER, sizeof(TEMP_BUFFER), ",\"ts\":%.3f", time_us);
+        out_ << TEMP_BUFFER;
+    }
+
+    void write_string(const char *str)
+    {
+        out_ << '"';
+        for (const char *c = str; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out_ << '\\';
+            }
+            if ((unsigned char)*c >= 0x20)
+            {
+                out_ << *c;
+            }
+        }
+        out_ << '"';
+    }
+
+private:
+    std::ofstream out_;
+    uint64_t start_time_;
+    bool first_event_{true};
+};
+
+void dump_trace()
+{
+    const uint64_t start_time = get_recorded_start_time();
+    const std::vector<ThreadProbesCopy> copies = copy_probes(start_time);
+    if (copies.empty())
+    {
+        return;
+    }
+
+    TraceWriter writer(DUMP_PATH.c_str(), start_time);
+    if (!writer.isOpen())
+    {
+        std::cout << "Can't write profiler trace to " << DUMP_PATH << std::endl;
+        return;
+    }
+
+    const uint64_t main_thread_id = Threads::getMainThreadId();
+    for (const ThreadProbesCopy &copy : copies)
+    {
+        if (!copy.name.empty())
+        {
+            writer.writeThreadName(copy.thread_id, copy.name);
+        }
+        else if (copy.thread_id == main_thread_id)
+        {
+            writer.writeThreadName(copy.thread_id, "Main");
+        }
+        else
+        {
+            writer.writeThreadName(copy.thread_id, "Thread " + std::to_string(copy.thread_id));
+        }
+
+        // The buffer may begin inside the scopes, their ends are skipped. The scopes still open
+        // are ended by the last probe
+        int depth = 0;
+        for (const ProbeInfo &probe : copy.probes)
+        {
+            if (probe.name)
+            {
+                writer.writeSlice(probe.name, 'B', copy.thread_id, probe.time);
+                ++depth;
+            }
+            else if (depth > 0)
+            {
+                writer.writeSlice("", 'E', copy.thread_id, probe.time);
+                --depth;
+            }
+        }
+        for (; depth > 0; --depth)
+        {
+            writer.writeSlice("", 'E', copy.thread_id, copy.probes.back().time);
+        }
+    }
+
+    const uint64_t num_frames = std::min<uint64_t>(NUM_FRAMES, FRAME_BEGIN_TIMES.size());
+    for (uint64_t i = NUM_FRAMES - num_frames; i < NUM_FRAMES; ++i)
+    {
+        const uint64_t time = FRAME_BEGIN_TIMES[i % FRAME_BEGIN_TIMES.size()];
+        writer.writeFrameMarker(main_thread_id, time);
+        if (i + 1 < NUM_FRAMES)
+        {
+            const uint64_t next_time = FRAME_BEGIN_TIMES[(i + 1) % FRAME_BEGIN_TIMES.size()];
+            writer.writeCounter("Frame time, ms", time,
+                (double)(next_time - time) * 1000.0 / (double)PERF_FREQ);
+        }
+    }
+
+    for (const CounterInfo &counter : copy_counters(start_time))
+    {
+        if (counter.name)
+        {
+            writer.writeCounter(counter.name, counter.time, counter.value);
+        }
+    }
+}
 
 } // namespace
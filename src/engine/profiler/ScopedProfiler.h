@@ -4,10 +4,21 @@
 
 #include <cstdint>
 
+class ProfilerStats;
+
+// Static descriptor of a profiled scope, created at compile time by the macros below. The events
+// refer to it by the address, so an event is 16 bytes
+struct ProbeSite
+{
+    const char *name;
+    const char *file;
+    int line;
+};
+
 class ScopedProfiler
 {
 public:
-    explicit ScopedProfiler(const char *name);
+    explicit ScopedProfiler(const ProbeSite *site);
     ~ScopedProfiler();
 };
 
@@ -18,23 +29,52 @@ public:
 
     static void setMaxRecordedFrames(int frames);
 
-    static void enterFunction(const char *name, uint64_t time);
+    // The time is in the profiler clock ticks: TSC if it's invariant, the OS monotonic clock
+    // otherwise. The clock is selected and calibrated by init()
+    static void enterFunction(const ProbeSite *site, uint64_t time);
     static void leaveFunction(uint64_t time);
 
-    static void enterFunction(const char *name);
+    static void enterFunction(const ProbeSite *site);
     static void leaveFunction();
 
+    // Current time of the profiler clock, a scope reads it twice
+    static uint64_t getTicks();
+
+    // Sample of a time series value, e.g. a queue size. The samples of one name form a counter
+    // track in the trace. The name must outlive the profiler, string literals are expected
+    static void counter(const char *name, double value);
+
+    // Shown in the trace instead of the thread id
+    static void setThreadName(const char *name);
+
     static void beginFrame();
     static void endFrame();
 
     static void dumpSVG(const char *path);
     static void dumpHTML(const char *path);
+    // Chrome Trace Event JSON of the recorded frames
+    static void dumpTrace(const char *path);
+
+    // Aggregated at the end of each frame since the last reset, the percentiles over a window of
+    // frames, main thread only
+    static const ProfilerStats &getStats();
+    static void resetStats();
+    static bool dumpStatsCSV(const char *path);
 };
 
 #ifdef REALENGINE_ENABLE_PROFILER
-    #define SCOPED_FUNC_PROFILER ScopedProfiler REALENGINE_CONCATENATE(_profiler_, __LINE__)(__FUNCTION__)
-    #define SCOPED_PROFILER(name) ScopedProfiler REALENGINE_CONCATENATE(_profiler_, __LINE__)(name)
+    #define _REALENGINE_SCOPED_PROFILER(name, site_var, profiler_var)                              \
+        static constexpr ProbeSite site_var{name, __FILE__, __LINE__};                             \
+        ScopedProfiler profiler_var(&site_var)
+    #define SCOPED_FUNC_PROFILER                                                                   \
+        _REALENGINE_SCOPED_PROFILER(__FUNCTION__, REALENGINE_CONCATENATE(_probe_site_, __LINE__),  \
+            REALENGINE_CONCATENATE(_profiler_, __LINE__))
+    #define SCOPED_PROFILER(name)                                                                  \
+        _REALENGINE_SCOPED_PROFILER(name, REALENGINE_CONCATENATE(_probe_site_, __LINE__),          \
+            REALENGINE_CONCATENATE(_profiler_, __LINE__))
+    #define PROFILER_COUNTER(name, value) Profiler::counter(name, (double)(value))
 #else
     #define SCOPED_FUNC_PROFILER
     #define SCOPED_PROFILER(name)
+    #define PROFILER_COUNTER(name, value)
 #endif
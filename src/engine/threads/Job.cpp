@@ -1,54 +1,34 @@
 #include "Job.h"
 
-#include <atomic>
-
-tbb::CancelToken::CancelToken(std::shared_ptr<std::atomic<bool>> job_alive,
-    std::shared_ptr<std::atomic<bool>> cancel_flag)
-    : job_alive_(std::move(job_alive))
-    , cancel_flag_(std::move(cancel_flag))
+tbb::JobHandle::JobHandle(Job *job)
+    : job_(job)
 {
-    assert(job_alive_);
-    assert(cancel_flag_);
+    assert(job_);
 }
 
-bool tbb::CancelToken::isCanceled() const
+bool tbb::JobHandle::isCanceled() const
 {
-    return cancel_flag_->load();
+    return job_->isCanceled();
 }
 
-void tbb::CancelToken::cancel()
+void tbb::JobHandle::cancel()
 {
-    cancel_flag_->store(true);
+    job_->cancel();
 }
 
-bool tbb::CancelToken::isAlive() const
+void tbb::JobHandle::setPriorityKey(int64_t key)
 {
-    return job_alive_->load();
+    job_->setPriorityKey(key);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-tbb::Job::Job()
-    : job_alive_(std::make_shared<std::atomic<bool>>(true))
-    , cancel_flag_(std::make_shared<std::atomic<bool>>(false))
-{}
-
-tbb::Job::~Job()
-{
-    job_alive_->store(false);
-}
+tbb::Job::Job() = default;
 
-bool tbb::Job::isCanceled() const
-{
-    return cancel_flag_->load();
-}
+tbb::Job::~Job() = default;
 
-void tbb::Job::cancel()
+void tbb::Job::setPriority(JobPriority priority, int64_t key)
 {
-    cancel_flag_->store(true);
+    priority_ = priority;
+    setPriorityKey(key);
 }
-
-tbb::CancelToken tbb::Job::getCancelToken() const
-{
-    return CancelToken(job_alive_, cancel_flag_);
-}
\ No newline at end of file
@@ -1,23 +1,41 @@
 #pragma once
 #include "Base.h"
 
+#include <atomic>
+#include <cstdint>
+
 namespace tbb
 {
 
-class CancelToken
+class Job;
+class JobQueue;
+
+// Jobs are taken by the priority class first, then in the enqueue order.
+// JobQueue::updatePriorities() re-sorts the queued jobs of each class by the priority key (lower
+// is first). Normal jobs enqueued from a worker go to the worker's own deque, the worker takes
+// them before the other Normal jobs
+enum class JobPriority : uint8_t
+{
+    High,
+    Normal,
+    Low,
+};
+
+// Handle to an enqueued job. The state is stored in the job itself, so the handle can be used
+// only until the job's finishMainThread() returns
+class JobHandle
 {
 public:
-    explicit CancelToken(std::shared_ptr<std::atomic<bool>> job_alive,
-        std::shared_ptr<std::atomic<bool>> cancel_flag);
+    explicit JobHandle(Job *job);
 
     bool isCanceled() const;
     void cancel();
 
-    bool isAlive() const;
+    // Applied to the queued job by JobQueue::updatePriorities()
+    void setPriorityKey(int64_t key);
 
 private:
-    std::shared_ptr<std::atomic<bool>> job_alive_;
-    std::shared_ptr<std::atomic<bool>> cancel_flag_;
+    Job *job_;
 };
 
 class Job
@@ -30,16 +48,27 @@ public:
 
     virtual void execute() = 0;
 
-    bool isCanceled() const;
-    void cancel();
-    CancelToken getCancelToken() const;
+    bool isCanceled() const { return canceled_.load(std::memory_order_relaxed); }
+    void cancel() { canceled_.store(true, std::memory_order_relaxed); }
+    JobHandle getHandle() { return JobHandle(this); }
+
+    // The class can't be changed after the job is enqueued, the key can
+    void setPriority(JobPriority priority, int64_t key = 0);
+    void setPriorityKey(int64_t key) { priority_key_.store(key, std::memory_order_relaxed); }
+    JobPriority getPriority() const { return priority_; }
+    int64_t getPriorityKey() const { return priority_key_.load(std::memory_order_relaxed); }
 
     virtual void finishWorkerThread() {}
     virtual void finishMainThread() {}
 
 private:
-    std::shared_ptr<std::atomic<bool>> job_alive_;
-    std::shared_ptr<std::atomic<bool>> cancel_flag_;
+    friend class JobQueue;
+
+    std::atomic<bool> canceled_{false};
+    JobPriority priority_{JobPriority::Normal};
+    std::atomic<int64_t> priority_key_{0};
+    Job *next_finished_{nullptr}; // intrusive list of the finished jobs
+    uint64_t finish_time_usec_{0};
 };
 
-} // namespace tbb
\ No newline at end of file
+} // namespace tbb
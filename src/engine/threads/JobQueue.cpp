@@ -1,20 +1,48 @@
 #include "JobQueue.h"
 
+#include "EngineGlobals.h"
 #include "Job.h"
 #include "Threads.h"
 #include "WorkerThread.h"
 #include "profiler/ScopedProfiler.h"
+#include "time/Time.h"
 #include "utils/Algos.h"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include <thread>
 
+namespace
+{
+
+// Of each priority class
+constexpr int CLASS_QUEUE_CAPACITY = 1 << 16;
+constexpr int WORKER_DEQUE_CAPACITY = 1 << 12;
+
+// Attempts to find a job before going to sleep
+constexpr int NUM_SPINS = 64;
+
+// Index of the worker of the current thread, -1 for the other threads
+thread_local int t_worker_index = -1;
+
+} // namespace
+
 namespace tbb
 {
 
-JobQueue::JobQueue()
+JobQueue::JobQueue(const JobQueueSettings &settings)
+    : settings_(settings)
+    , num_threads_(settings.num_threads)
 {
-    num_threads_ = std::thread::hardware_concurrency();
+    for (UPtr<MpmcQueue<Job>> &jobs : class_jobs_)
+    {
+        jobs = makeU<MpmcQueue<Job>>(CLASS_QUEUE_CAPACITY);
+    }
+    if (num_threads_ <= 0)
+    {
+        num_threads_ = std::thread::hardware_concurrency();
+    }
     if (num_threads_ <= 0)
     {
         num_threads_ = 1;
@@ -22,14 +50,45 @@ JobQueue::JobQueue()
     std::cout << "JobQueue: initialized with " << num_threads_ << " threads" << std::endl;
 }
 
-JobQueue::~JobQueue() {}
+JobQueue::~JobQueue()
+{
+    assert(threads_.empty());
+
+    Job *job = finished_jobs_.exchange(nullptr);
+    while (job)
+    {
+        UPtr<Job> finished(job);
+        job = job->next_finished_;
+    }
+    for (const PriorityEntry &entry : jobs_to_finish_)
+    {
+        delete entry.job;
+    }
+}
 
 void JobQueue::runWorkers()
 {
     assert(threads_.empty());
     for (int i = 0; i < num_threads_; ++i)
     {
-        threads_.push_back(makeU<WorkerThread>());
+        workers_.push_back(makeU<Worker>(WORKER_DEQUE_CAPACITY));
+        workers_.back()->random_state = 0x9e3779b9u * (i + 1);
+    }
+    const int num_cores = std::max<int>(std::thread::hardware_concurrency(), 1);
+    for (int i = 0; i < num_threads_; ++i)
+    {
+        UPtr<WorkerThread> thread = makeU<WorkerThread>(i);
+        thread->setName("Worker " + std::to_string(i));
+        if (settings_.pin_workers)
+        {
+            thread->setAffinity((settings_.first_core + i) % num_cores);
+        }
+        if (settings_.low_priority_workers)
+        {
+            thread->setPriority(Thread::Priority::Low);
+        }
+        thread->start();
+        threads_.push_back(std::move(thread));
     }
 }
 
@@ -39,7 +98,11 @@ void JobQueue::stopWorkers()
     {
         worker_thread->exit();
     }
-    jobs_cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++wake_epoch_;
+    }
+    sleep_cv_.notify_all();
 
     int wait_ms = 500;
     while (wait_ms > 0)
@@ -66,17 +129,12 @@ void JobQueue::stopWorkers()
 
     threads_.clear();
 
-    std::queue<UPtr<Job>> taken_jobs;
-    {
-        std::lock_guard<std::mutex> lock(jobs_mutex_);
-        std::swap(taken_jobs, jobs_);
-    }
-
-    const int num_jobs = taken_jobs.size();
-    while (!taken_jobs.empty())
+    int num_jobs = 0;
+    while (UPtr<Job> job = tryTakeJob())
     {
-        taken_jobs.pop();
+        ++num_jobs;
     }
+    workers_.clear();
 
     std::cout << "JobQueue: unfinished jobs " << num_jobs << std::endl;
 }
@@ -87,86 +145,195 @@ void JobQueue::finishJobsMainThread()
 
     SCOPED_FUNC_PROFILER;
 
-    std::queue<UPtr<Job>> taken_jobs;
+    const uint64_t begin_usec = eng.time->getTimeUsec();
+    const uint64_t frame = eng.time->getFrame();
+    if (frame != finish_frame_)
+    {
+        finish_frame_ = frame;
+        finish_spent_usec_ = 0;
+        num_finished_in_frame_ = 0;
+        max_finish_latency_usec_ = 0;
+    }
+
+    // The list is LIFO, reverse it to keep the finish order for the jobs of the same priority
+    Job *reversed = finished_jobs_.exchange(nullptr, std::memory_order_acquire);
+    Job *job = nullptr;
+    while (reversed)
+    {
+        Job *next = reversed->next_finished_;
+        reversed->next_finished_ = job;
+        job = reversed;
+        reversed = next;
+    }
+    while (job)
     {
-        std::lock_guard<std::mutex> lock(finished_mutex_);
-        std::swap(taken_jobs, finished_jobs_);
+        Job *next = job->next_finished_;
+        job->next_finished_ = nullptr;
+        jobs_to_finish_.push_back(
+            {job->getPriority(), job->getPriorityKey(), next_finish_order_++, job});
+        std::push_heap(jobs_to_finish_.begin(), jobs_to_finish_.end(), &is_worse);
+        job = next;
     }
 
-    while (!taken_jobs.empty())
+    uint64_t now_usec = begin_usec;
+    while (!jobs_to_finish_.empty())
     {
-        UPtr<Job> job = std::move(taken_jobs.front());
-        taken_jobs.pop();
-        job->finishMainThread();
+        const uint64_t spent_usec = finish_spent_usec_ + (now_usec - begin_usec);
+        if (finish_budget_usec_ > 0 && spent_usec >= finish_budget_usec_
+            && num_finished_in_frame_ > 0)
+        {
+            break;
+        }
+
+        std::pop_heap(jobs_to_finish_.begin(), jobs_to_finish_.end(), &is_worse);
+        UPtr<Job> finished(jobs_to_finish_.back().job);
+        jobs_to_finish_.pop_back();
+
+        // The job may be finished after begin_usec was taken
+        const uint64_t latency_usec =
+            now_usec > finished->finish_time_usec_ ? now_usec - finished->finish_time_usec_ : 0;
+        max_finish_latency_usec_ = std::max(max_finish_latency_usec_, latency_usec);
+
+        finished->finishMainThread();
+        ++num_finished_in_frame_;
+        now_usec = eng.time->getTimeUsec();
     }
+    finish_spent_usec_ += now_usec - begin_usec;
+
+    PROFILER_COUNTER("Queued jobs", getNumJobs());
+    PROFILER_COUNTER("Busy workers", getNumBusyThreads());
+    PROFILER_COUNTER("Deferred finishes", jobs_to_finish_.size());
+}
+
+void JobQueue::setFinishBudgetUsec(uint64_t budget_usec)
+{
+    finish_budget_usec_ = budget_usec;
 }
 
 void JobQueue::enqueueJob(UPtr<Job> job)
 {
+    assert(job);
+    Job *raw_job = job.release();
+
+    // The High and Low jobs of a worker are queued by the class, so the local work doesn't
+    // delay a High job and isn't delayed by a Low one
+    const int worker_index = t_worker_index;
+    if (worker_index < 0 || raw_job->getPriority() != JobPriority::Normal
+        || !workers_[worker_index]->deque.push(raw_job))
     {
-        std::lock_guard<std::mutex> lock(jobs_mutex_);
-        jobs_.push(std::move(job));
+        push_class_job(raw_job);
     }
-    jobs_cv_.notify_one();
+    wake_worker();
+}
+
+void JobQueue::updatePriorities()
+{
+    assert(Threads::isMainThread());
+
+    SCOPED_FUNC_PROFILER;
+
+    // The workers keep taking the jobs meanwhile, the jobs enqueued by them during the sort are
+    // queued after the sorted ones
+    for (const UPtr<MpmcQueue<Job>> &jobs : class_jobs_)
+    {
+        jobs_to_sort_.clear();
+        for (int i = jobs->getSize(); i > 0; --i)
+        {
+            Job *job = jobs->pop();
+            if (!job)
+            {
+                break;
+            }
+            jobs_to_sort_.push_back(job);
+        }
+        // Stable, the jobs with the same key stay in the enqueue order
+        std::stable_sort(jobs_to_sort_.begin(), jobs_to_sort_.end(), [](Job *lhs, Job *rhs) {
+            return lhs->getPriorityKey() < rhs->getPriorityKey();
+        });
+        for (Job *job : jobs_to_sort_)
+        {
+            push_class_job(job);
+        }
+    }
+    jobs_to_sort_.clear();
 }
 
 void JobQueue::addFinishedJob(UPtr<Job> job)
 {
-    std::lock_guard<std::mutex> lock(finished_mutex_);
-    finished_jobs_.push(std::move(job));
+    Job *raw_job = job.release();
+    raw_job->finish_time_usec_ = eng.time->getTimeUsec();
+    Job *head = finished_jobs_.load(std::memory_order_relaxed);
+    do
+    {
+        raw_job->next_finished_ = head;
+    } while (!finished_jobs_.compare_exchange_weak(head, raw_job, std::memory_order_release,
+        std::memory_order_relaxed));
 }
 
 UPtr<Job> JobQueue::takeJobWaiting(const WorkerThread &thread)
 {
-    UPtr<Job> job;
-    {
-        std::unique_lock lock(jobs_mutex_);
+    const int worker_index = thread.getIndex();
+    t_worker_index = worker_index;
 
-        if (!jobs_.empty())
+    while (!thread.needExit())
+    {
+        for (int i = 0; i < NUM_SPINS; ++i)
         {
-            job = std::move(jobs_.front());
-            jobs_.pop();
+            if (Job *job = take_job(worker_index))
+            {
+                return UPtr<Job>(job);
+            }
+            std::this_thread::yield();
         }
 
+        std::unique_lock lock(sleep_mutex_);
+        num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // A job enqueued before the counter increment is seen here, a job enqueued after it
+        // wakes the worker
+        Job *job = take_job(worker_index);
         if (!job && !thread.needExit())
         {
-            while (true)
-            {
-                jobs_cv_.wait(lock);
-                if (!jobs_.empty() || thread.needExit())
-                {
-                    break;
-                }
-            }
-            assert(lock.owns_lock());
-            if (!jobs_.empty())
-            {
-                job = std::move(jobs_.front());
-                jobs_.pop();
-            }
+            const uint64_t epoch = wake_epoch_;
+            sleep_cv_.wait(lock, [&] { return wake_epoch_ != epoch || thread.needExit(); });
+        }
+        num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (job)
+        {
+            return UPtr<Job>(job);
         }
     }
-    return job;
+    return nullptr;
 }
 
 UPtr<Job> JobQueue::tryTakeJob()
 {
-    UPtr<Job> job;
+    for (const JobPriority priority : {JobPriority::High, JobPriority::Normal})
     {
-        std::lock_guard<std::mutex> lock(jobs_mutex_);
-        if (!jobs_.empty())
+        if (Job *job = take_class_job(priority))
         {
-            job = std::move(jobs_.front());
-            jobs_.pop();
+            return UPtr<Job>(job);
         }
     }
-    return job;
+    if (Job *job = steal_job(-1))
+    {
+        return UPtr<Job>(job);
+    }
+    return UPtr<Job>(take_class_job(JobPriority::Low));
 }
 
-int JobQueue::getNumJobs()
+int JobQueue::getNumJobs() const
 {
-    std::lock_guard<std::mutex> lock(jobs_mutex_);
-    return jobs_.size();
+    int num_jobs = 0;
+    for (const UPtr<MpmcQueue<Job>> &jobs : class_jobs_)
+    {
+        num_jobs += jobs->getSize();
+    }
+    for (const UPtr<Worker> &worker : workers_)
+    {
+        num_jobs += worker->deque.getSize();
+    }
+    return num_jobs;
 }
 
 int JobQueue::getNumThreads() const
@@ -184,4 +351,111 @@ int JobQueue::getNumBusyThreads() const
     return ret;
 }
 
+int JobQueue::getNumDeferredFinishes() const
+{
+    return jobs_to_finish_.size();
+}
+
+uint64_t JobQueue::getMaxFinishLatencyUsec() const
+{
+    return max_finish_latency_usec_;
+}
+
+Job *JobQueue::take_job(int worker_index)
+{
+    if (Job *job = take_class_job(JobPriority::High))
+    {
+        return job;
+    }
+    // Only the Normal jobs are in the deques
+    if (Job *job = workers_[worker_index]->deque.pop())
+    {
+        return job;
+    }
+    if (Job *job = take_class_job(JobPriority::Normal))
+    {
+        return job;
+    }
+    if (Job *job = steal_job(worker_index))
+    {
+        return job;
+    }
+    return take_class_job(JobPriority::Low);
+}
+
+Job *JobQueue::take_class_job(JobPriority priority)
+{
+    return class_jobs_[(int)priority]->pop();
+}
+
+bool JobQueue::is_worse(const PriorityEntry &lhs, const PriorityEntry &rhs)
+{
+    if (lhs.priority != rhs.priority)
+    {
+        return lhs.priority > rhs.priority;
+    }
+    if (lhs.key != rhs.key)
+    {
+        return lhs.key > rhs.key;
+    }
+    return lhs.order > rhs.order;
+}
+
+void JobQueue::push_class_job(Job *job)
+{
+    MpmcQueue<Job> &jobs = *class_jobs_[(int)job->getPriority()];
+    while (!jobs.push(job))
+    {
+        // Full, the workers are going to take some jobs
+        std::this_thread::yield();
+    }
+}
+
+Job *JobQueue::steal_job(int worker_index)
+{
+    const int num_workers = (int)workers_.size();
+    if (num_workers == 0 || (num_workers == 1 && worker_index == 0))
+    {
+        return nullptr;
+    }
+
+    // Start from a random victim, then try all of them
+    int start = 0;
+    if (worker_index >= 0)
+    {
+        uint32_t &state = workers_[worker_index]->random_state;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        start = (int)(state % (uint32_t)num_workers);
+    }
+    for (int i = 0; i < num_workers; ++i)
+    {
+        const int victim = (start + i) % num_workers;
+        if (victim == worker_index)
+        {
+            continue;
+        }
+        if (Job *job = workers_[victim]->deque.steal())
+        {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobQueue::wake_worker()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_sleeping_.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++wake_epoch_;
+    }
+    sleep_cv_.notify_one();
+}
+
 } // namespace tbb
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Base.h"
+#include "Job.h"
+#include "MpmcQueue.h"
+#include "WorkStealingDeque.h"
 
-#include <queue>
-
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <vector>
 
@@ -18,41 +21,115 @@ class WorkerThread;
 namespace tbb
 {
 
+struct JobQueueSettings
+{
+    // 0 - hardware concurrency
+    int num_threads{0};
+    // Worker i runs only on the core (first_core + i) % cores, core 0 is left to the main thread
+    bool pin_workers{false};
+    int first_core{1};
+    // The generation and meshing never preempt the main/render thread
+    bool low_priority_workers{true};
+};
 
+// Work-stealing scheduler. Each priority class has its own lock-free FIFO, the Normal jobs
+// enqueued by a worker go to the worker's own deque instead. An idle worker takes a High job
+// first, then a job from its deque, a Normal job, steals from the other workers and takes a Low
+// job last, so the local work never delays the High jobs. The keys are applied by
+// updatePriorities(). The finished jobs are collected in a lock-free list and finished on the
+// main thread in the priority order, within the frame's time budget
 class JobQueue
 {
 public:
     REMOVE_COPY_MOVE_CLASS(JobQueue);
 
-    JobQueue();
+    explicit JobQueue(const JobQueueSettings &settings = JobQueueSettings());
     ~JobQueue();
 
     void runWorkers();
     void stopWorkers();
 
+    // Finishes the jobs until the frame's budget is spent, at least one job per frame. The rest is
+    // left for the next calls
     void finishJobsMainThread();
+    // 0 - unlimited
+    void setFinishBudgetUsec(uint64_t budget_usec);
 
     void enqueueJob(UPtr<Job> job);
 
+    // Re-sorts the jobs of each class by the keys set with JobHandle::setPriorityKey(), the jobs
+    // in the worker deques keep their order. Main thread only
+    void updatePriorities();
+
     void addFinishedJob(UPtr<Job> job);
 
     UPtr<Job> takeJobWaiting(const WorkerThread &thread);
     UPtr<Job> tryTakeJob();
-    int getNumJobs();
+    // Approximate
+    int getNumJobs() const;
 
     int getNumThreads() const;
     int getNumBusyThreads() const;
 
+    // Finished on the workers, waiting for finishJobsMainThread()
+    int getNumDeferredFinishes() const;
+    // Max time from the job's end on a worker to its finishMainThread() in the current frame
+    uint64_t getMaxFinishLatencyUsec() const;
+
 private:
+    struct Worker
+    {
+        explicit Worker(int deque_capacity)
+            : deque(deque_capacity)
+        {}
+
+        WorkStealingDeque<Job> deque;
+        uint32_t random_state{1};
+    };
+
+    struct PriorityEntry
+    {
+        JobPriority priority;
+        int64_t key;
+        uint64_t order;
+        Job *job;
+    };
+
+    Job *take_job(int worker_index);
+    Job *take_class_job(JobPriority priority);
+    Job *steal_job(int worker_index);
+    // "Less" of the max-heap: lhs is taken after rhs
+    static bool is_worse(const PriorityEntry &lhs, const PriorityEntry &rhs);
+    void push_class_job(Job *job);
+    void wake_worker();
+
+private:
+    JobQueueSettings settings_;
     int num_threads_{};
     std::vector<UPtr<WorkerThread>> threads_;
-
-    std::mutex jobs_mutex_;
-    std::queue<UPtr<Job>> jobs_;
-    std::condition_variable jobs_cv_;
-
-    std::mutex finished_mutex_;
-    std::queue<UPtr<Job>> finished_jobs_;
+    std::vector<UPtr<Worker>> workers_;
+
+    static constexpr int NUM_PRIORITIES = 3;
+    // By JobPriority
+    UPtr<MpmcQueue<Job>> class_jobs_[NUM_PRIORITIES];
+
+    // Sleeping workers are woken only if there are any, so enqueue doesn't lock in the busy case
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int> num_sleeping_{0};
+    uint64_t wake_epoch_{0}; // guarded by sleep_mutex_
+
+    std::atomic<Job *> finished_jobs_{nullptr};
+
+    // Main thread only
+    std::vector<Job *> jobs_to_sort_;
+    std::vector<PriorityEntry> jobs_to_finish_; // heap, the best job is the first
+    uint64_t next_finish_order_{0};
+    uint64_t finish_budget_usec_{0};
+    uint64_t finish_frame_{UINT64_MAX};
+    uint64_t finish_spent_usec_{0};
+    int num_finished_in_frame_{0};
+    uint64_t max_finish_latency_usec_{0};
 };
 
 } // namespace tbb
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Base.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace tbb
+{
+
+// Bounded lock-free multi-producer multi-consumer FIFO of pointers (D. Vyukov's array queue)
+template<typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(int capacity)
+        : mask_(capacity - 1)
+        , cells_(std::make_unique<Cell[]>(capacity))
+    {
+        assert(capacity > 1 && (capacity & (capacity - 1)) == 0);
+        for (int i = 0; i < capacity; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    REMOVE_COPY_MOVE_CLASS(MpmcQueue);
+
+    // Returns false if the queue is full
+    bool push(T *item)
+    {
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const int64_t diff = (int64_t)sequence - (int64_t)pos;
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns null if the queue is empty
+    T *pop()
+    {
+        uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const int64_t diff = (int64_t)sequence - (int64_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        T *item = cell->item;
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return item;
+    }
+
+    // Approximate if other threads use the queue
+    int getSize() const
+    {
+        const uint64_t enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+        const uint64_t dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueue_pos > dequeue_pos ? (int)(enqueue_pos - dequeue_pos) : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence{0};
+        T *item{nullptr};
+    };
+
+    const uint64_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+};
+
+} // namespace tbb
@@ -0,0 +1,313 @@
+#include "Parallel.h"
+
+#include "EngineGlobals.h"
+#include "Job.h"
+#include "JobQueue.h"
+#include "Threads.h"
+#include "profiler/ScopedProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct ParallelForState
+{
+    const std::function<void(int, int)> *fn{};
+    int begin{};
+    int end{};
+    int grain{};
+    int num_chunks{};
+    std::atomic<int> next_chunk{0};
+    std::atomic<int> num_finished_chunks{0};
+};
+
+// Returns false if there are no chunks left
+bool run_parallel_for_chunk(ParallelForState &state)
+{
+    const int chunk = state.next_chunk.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= state.num_chunks)
+    {
+        return false;
+    }
+    const int chunk_begin = state.begin + chunk * state.grain;
+    const int chunk_end = std::min(chunk_begin + state.grain, state.end);
+    (*state.fn)(chunk_begin, chunk_end);
+    state.num_finished_chunks.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+// The job may be taken after parallelFor() returned, the state is shared for that
+class ParallelForJob : public tbb::Job
+{
+public:
+    explicit ParallelForJob(std::shared_ptr<ParallelForState> state)
+        : state_(std::move(state))
+    {}
+
+    void execute() override
+    {
+        SCOPED_PROFILER("parallelFor job");
+        while (run_parallel_for_chunk(*state_))
+        {
+        }
+    }
+
+private:
+    std::shared_ptr<ParallelForState> state_;
+};
+
+} // namespace
+
+namespace tbb
+{
+
+void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &fn)
+{
+    SCOPED_FUNC_PROFILER;
+
+    assert(grain > 0);
+    if (begin >= end)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = &fn;
+    state->begin = begin;
+    state->end = end;
+    state->grain = grain;
+    state->num_chunks = (end - begin + grain - 1) / grain;
+
+    const int num_jobs = std::min(eng.queue->getNumThreads(), state->num_chunks - 1);
+    for (int i = 0; i < num_jobs; ++i)
+    {
+        UPtr<ParallelForJob> job = makeU<ParallelForJob>(state);
+        job->setPriority(JobPriority::High);
+        eng.queue->enqueueJob(std::move(job));
+    }
+
+    while (run_parallel_for_chunk(*state))
+    {
+    }
+    while (state->num_finished_chunks.load(std::memory_order_acquire) < state->num_chunks)
+    {
+        std::this_thread::yield();
+    }
+}
+
+struct TaskGraph::State
+{
+    struct Task
+    {
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        int num_predecessors{0};
+        std::atomic<int> num_pending{0};
+    };
+
+    std::vector<UPtr<Task>> tasks;
+    std::function<void()> continuation;
+
+    std::mutex ready_mutex;
+    std::vector<TaskId> ready_tasks;
+
+    std::atomic<int> num_unfinished{0};
+    std::atomic<bool> continuation_called{false};
+};
+
+namespace
+{
+
+using GraphState = TaskGraph::State;
+
+void push_ready_task(const std::shared_ptr<GraphState> &state, TaskGraph::TaskId id);
+
+void call_continuation(GraphState &state)
+{
+    assert(Threads::isMainThread());
+    if (!state.continuation_called.exchange(true) && state.continuation)
+    {
+        SCOPED_PROFILER("TaskGraph continuation");
+        state.continuation();
+    }
+}
+
+class ContinuationJob : public Job
+{
+public:
+    explicit ContinuationJob(std::shared_ptr<GraphState> state)
+        : state_(std::move(state))
+    {}
+
+    void execute() override {}
+    void finishMainThread() override { call_continuation(*state_); }
+
+private:
+    std::shared_ptr<GraphState> state_;
+};
+
+void on_graph_finished(const std::shared_ptr<GraphState> &state)
+{
+    if (state->continuation)
+    {
+        UPtr<ContinuationJob> job = makeU<ContinuationJob>(state);
+        job->setPriority(JobPriority::High);
+        eng.queue->enqueueJob(std::move(job));
+    }
+}
+
+// Returns false if there are no ready tasks
+bool run_ready_task(const std::shared_ptr<GraphState> &state)
+{
+    TaskGraph::TaskId id = -1;
+    {
+        std::lock_guard<std::mutex> lock(state->ready_mutex);
+        if (state->ready_tasks.empty())
+        {
+            return false;
+        }
+        id = state->ready_tasks.back();
+        state->ready_tasks.pop_back();
+    }
+
+    GraphState::Task &task = *state->tasks[id];
+    task.fn();
+
+    for (const TaskGraph::TaskId successor : task.successors)
+    {
+        if (state->tasks[successor]->num_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            push_ready_task(state, successor);
+        }
+    }
+    if (state->num_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        on_graph_finished(state);
+    }
+    return true;
+}
+
+// One job per ready task, the task may be taken by TaskGraph::wait() before the job is executed
+class TaskJob : public Job
+{
+public:
+    explicit TaskJob(std::shared_ptr<GraphState> state)
+        : state_(std::move(state))
+    {}
+
+    void execute() override
+    {
+        SCOPED_PROFILER("TaskGraph job");
+        run_ready_task(state_);
+    }
+
+private:
+    std::shared_ptr<GraphState> state_;
+};
+
+void push_ready_task(const std::shared_ptr<GraphState> &state, TaskGraph::TaskId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(state->ready_mutex);
+        state->ready_tasks.push_back(id);
+    }
+    UPtr<TaskJob> job = makeU<TaskJob>(state);
+    job->setPriority(JobPriority::High);
+    eng.queue->enqueueJob(std::move(job));
+}
+
+} // namespace
+
+TaskGraph::TaskGraph()
+    : state_(std::make_shared<State>())
+{}
+
+TaskGraph::~TaskGraph() = default;
+
+TaskGraph::TaskId TaskGraph::addTask(std::function<void()> fn)
+{
+    assert(!started_);
+    assert(fn);
+    UPtr<State::Task> task = makeU<State::Task>();
+    task->fn = std::move(fn);
+    state_->tasks.push_back(std::move(task));
+    return (TaskId)state_->tasks.size() - 1;
+}
+
+void TaskGraph::addDependency(TaskId before, TaskId after)
+{
+    assert(!started_);
+    assert(before != after);
+    assert(before >= 0 && before < (TaskId)state_->tasks.size());
+    assert(after >= 0 && after < (TaskId)state_->tasks.size());
+    state_->tasks[before]->successors.push_back(after);
+    ++state_->tasks[after]->num_predecessors;
+}
+
+void TaskGraph::setContinuation(std::function<void()> fn)
+{
+    assert(!started_);
+    state_->continuation = std::move(fn);
+}
+
+void TaskGraph::run()
+{
+    SCOPED_FUNC_PROFILER;
+
+    assert(!started_);
+    started_ = true;
+
+    std::vector<TaskId> roots;
+    for (int i = 0; i < (int)state_->tasks.size(); ++i)
+    {
+        State::Task &task = *state_->tasks[i];
+        task.num_pending.store(task.num_predecessors, std::memory_order_relaxed);
+        if (task.num_predecessors == 0)
+        {
+            roots.push_back(i);
+        }
+    }
+    // A graph with a cycle would never finish
+    assert(state_->tasks.empty() || !roots.empty());
+
+    state_->num_unfinished.store(state_->tasks.size(), std::memory_order_relaxed);
+    if (state_->tasks.empty())
+    {
+        on_graph_finished(state_);
+        return;
+    }
+    for (const TaskId id : roots)
+    {
+        push_ready_task(state_, id);
+    }
+}
+
+void TaskGraph::wait()
+{
+    SCOPED_FUNC_PROFILER;
+
+    assert(started_);
+    while (!isFinished())
+    {
+        if (!run_ready_task(state_))
+        {
+            std::this_thread::yield();
+        }
+    }
+    if (Threads::isMainThread())
+    {
+        call_continuation(*state_);
+    }
+}
+
+bool TaskGraph::isFinished() const
+{
+    return state_->num_unfinished.load(std::memory_order_acquire) == 0;
+}
+
+} // namespace tbb
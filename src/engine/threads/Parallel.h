@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Base.h"
+
+#include <functional>
+#include <memory>
+
+namespace tbb
+{
+
+// Calls fn(sub_begin, sub_end) for the sub-ranges of [begin, end) of about grain elements on the
+// workers and the calling thread. The calling thread takes the sub-ranges too and waits only for
+// the ones already being executed, so it doesn't depend on the jobs queued before. Can be called
+// from a job
+void parallelFor(int begin, int end, int grain, const std::function<void(int, int)> &fn);
+
+// Tasks with dependencies. A task is started once all the tasks it depends on are finished, the
+// continuation is called on the main thread after all the tasks. The graph is built first, then
+// run() enqueues it, the tasks are executed in the jobs of the queue
+class TaskGraph
+{
+public:
+    REMOVE_COPY_MOVE_CLASS(TaskGraph);
+
+    using TaskId = int;
+
+    TaskGraph();
+    ~TaskGraph();
+
+    TaskId addTask(std::function<void()> fn);
+    // after is started once before is finished
+    void addDependency(TaskId before, TaskId after);
+    void setContinuation(std::function<void()> fn);
+
+    void run();
+    // Executes the ready tasks on the calling thread until all the tasks are finished. Called on
+    // the main thread, calls the continuation before returning
+    void wait();
+    bool isFinished() const;
+
+    // Shared with the jobs, which may outlive the graph
+    struct State;
+
+private:
+    std::shared_ptr<State> state_;
+    bool started_{false};
+};
+
+} // namespace tbb
@@ -1,19 +1,46 @@
 #include "Thread.h"
 
-#include <windows.h>
+#include "Threads.h"
+#include "profiler/ScopedProfiler.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sched.h>
+    #include <sys/resource.h>
+#endif
+
+#include <iostream>
 
 namespace
 {
 
+#ifdef _WIN32
 DWORD WINAPI run_thread(LPVOID param)
 {
     auto thread = static_cast<Thread *>(param);
     thread->run();
     return 0;
 }
+#else
+// Nice value added to the low priority threads
+constexpr int LOW_PRIORITY_NICE = 5;
+
+// Including the terminating zero
+constexpr size_t MAX_THREAD_NAME_SIZE = 16;
+
+void *run_thread(void *param)
+{
+    auto thread = static_cast<Thread *>(param);
+    thread->run();
+    return nullptr;
+}
+#endif
 
 } // namespace
 
+#ifdef _WIN32
+
 Thread::Thread()
 {
     DWORD thread_id;
@@ -21,22 +48,28 @@ Thread::Thread()
         0,                          // Default stack size
         &run_thread,                // Thread function
         this,                       // Thread parameters
-        0,                          // Default creation flags
+        CREATE_SUSPENDED,           // Started by start()
         &thread_id                  // Receive thread ID
     );
     id_ = thread_id;
 }
 
-Thread::~Thread()
+void Thread::start()
 {
-    exit();
-    join();
+    assert(handle_ && !started_);
+    started_ = true;
+    ResumeThread(handle_);
 }
 
 void Thread::join()
 {
     if (handle_)
     {
+        if (!started_)
+        {
+            // Never started, let it run to see the exit flag
+            start();
+        }
         WaitForSingleObject(handle_, INFINITE);
         CloseHandle(handle_);
         handle_ = nullptr;
@@ -44,17 +77,128 @@ void Thread::join()
     }
 }
 
-void Thread::exit()
+void Thread::kill()
 {
-    exit_.store(true);
+    TerminateThread(handle_, 0);
+    finished_.store(true);
+}
+
+void Thread::apply_settings()
+{
+    if (!name_.empty())
+    {
+        const std::wstring wide_name(name_.begin(), name_.end());
+        SetThreadDescription(GetCurrentThread(), wide_name.c_str());
+    }
+    if (affinity_core_ >= 0)
+    {
+        const DWORD_PTR mask = DWORD_PTR(1) << affinity_core_;
+        if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+        {
+            std::cout << "Thread: can't set affinity to core " << affinity_core_ << std::endl;
+        }
+    }
+    if (priority_ == Priority::Low)
+    {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    }
+}
+
+#else
+
+// pthreads can't be created suspended, the thread is created by start()
+Thread::Thread() = default;
+
+void Thread::start()
+{
+    assert(!started_);
+    started_ = true;
+    created_ = pthread_create(&handle_, nullptr, &run_thread, this) == 0;
+    if (!created_)
+    {
+        std::cout << "Thread: can't create thread" << std::endl;
+        finished_.store(true);
+    }
+}
+
+void Thread::join()
+{
+    if (created_)
+    {
+        pthread_join(handle_, nullptr);
+        created_ = false;
+        id_ = 0;
+    }
 }
 
 void Thread::kill()
 {
-    TerminateThread(handle_, 0);
+    if (created_)
+    {
+        // Detached, the thread may never reach a cancellation point
+        pthread_cancel(handle_);
+        pthread_detach(handle_);
+        created_ = false;
+    }
     finished_.store(true);
 }
 
+void Thread::apply_settings()
+{
+    if (!name_.empty())
+    {
+        const std::string short_name = name_.substr(0, MAX_THREAD_NAME_SIZE - 1);
+        pthread_setname_np(pthread_self(), short_name.c_str());
+    }
+    if (affinity_core_ >= 0)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(affinity_core_, &cpu_set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+        {
+            std::cout << "Thread: can't set affinity to core " << affinity_core_ << std::endl;
+        }
+    }
+    if (priority_ == Priority::Low)
+    {
+        // The nice value is per thread on Linux
+        const id_t tid = Threads::getCurrentThreadId();
+        setpriority(PRIO_PROCESS, tid, getpriority(PRIO_PROCESS, tid) + LOW_PRIORITY_NICE);
+    }
+}
+
+#endif
+
+Thread::~Thread()
+{
+    exit();
+    join();
+}
+
+void Thread::setName(std::string name)
+{
+    assert(!started_);
+    name_ = std::move(name);
+}
+
+void Thread::setAffinity(int core)
+{
+    assert(!started_);
+    affinity_core_ = core;
+}
+
+void Thread::setPriority(Priority priority)
+{
+    assert(!started_);
+    priority_ = priority;
+}
+
+void Thread::exit()
+{
+    exit_.store(true);
+}
+
 bool Thread::needExit() const
 {
     return exit_.load();
@@ -62,6 +206,13 @@ bool Thread::needExit() const
 
 void Thread::run()
 {
+    id_ = Threads::getCurrentThreadId();
+    apply_settings();
+    if (!name_.empty())
+    {
+        Profiler::setThreadName(name_.c_str());
+    }
+
     finished_.store(false);
     execute();
     finished_.store(true);
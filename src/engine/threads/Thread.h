@@ -4,15 +4,36 @@
 
 #include <atomic>
 #include <cstdint>
+#include <string>
+
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
 
 class Thread
 {
 public:
     REMOVE_COPY_MOVE_CLASS(Thread);
 
+    enum class Priority
+    {
+        Normal,
+        // Below the main thread, so it's never preempted by the thread
+        Low,
+    };
+
+    // The thread is created suspended, execute() is called after start(), so the derived class
+    // is fully constructed
     Thread();
     virtual ~Thread();
 
+    // Applied by the thread itself when it starts, so they must be set before start()
+    void setName(std::string name);
+    // -1 - any core
+    void setAffinity(int core);
+    void setPriority(Priority priority);
+
+    void start();
     void join();
     void exit();
 
@@ -29,9 +50,22 @@ public:
     uint64_t getId() const;
 
 private:
-    std::atomic<bool> exit_;
+    void apply_settings();
+
+private:
+    std::atomic<bool> exit_{false};
+#ifdef _WIN32
     void *handle_{};
-    uint64_t id_{};
+#else
+    pthread_t handle_{};
+    bool created_{false};
+#endif
+    std::atomic<uint64_t> id_{0};
+    bool started_{false};
+
+    std::string name_;
+    int affinity_core_{-1};
+    Priority priority_{Priority::Normal};
 
-    std::atomic<bool> finished_;
+    std::atomic<bool> finished_{false};
 };
@@ -1,7 +1,13 @@
 #include "Threads.h"
 
-#include <windows.h>
-
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <chrono>
 #include <thread>
 
 uint64_t Threads::main_thread_ = 0;
@@ -15,12 +21,18 @@ void Threads::shutdown() {}
 
 bool Threads::isMainThread()
 {
-    return GetCurrentThreadId() == main_thread_;
+    return getCurrentThreadId() == main_thread_;
 }
 
 uint64_t Threads::getCurrentThreadId()
 {
+#ifdef _WIN32
     return GetCurrentThreadId();
+#else
+    // Cached, the syscall is called once per thread
+    static thread_local const uint64_t thread_id = syscall(SYS_gettid);
+    return thread_id;
+#endif
 }
 
 uint64_t Threads::getMainThreadId()
@@ -30,5 +42,9 @@ uint64_t Threads::getMainThreadId()
 
 void Threads::sleepMs(uint64_t ms)
 {
+#ifdef _WIN32
     Sleep(ms);
-}
\ No newline at end of file
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
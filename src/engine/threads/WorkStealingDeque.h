@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Base.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace tbb
+{
+
+// Chase-Lev deque of pointers with a fixed capacity. The owner thread pushes and pops at the
+// bottom (LIFO), other threads steal from the top (FIFO)
+template<typename T>
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(int capacity)
+        : mask_(capacity - 1)
+        , items_(capacity)
+    {
+        assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    }
+
+    REMOVE_COPY_MOVE_CLASS(WorkStealingDeque);
+
+    // Owner only, returns false if the deque is full
+    bool push(T *item)
+    {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        if (b - t > mask_)
+        {
+            return false;
+        }
+        items_[b & mask_].store(item, std::memory_order_relaxed);
+        // Publishes the item to the thieves
+        bottom_.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Owner only
+    T *pop()
+    {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *item = items_[b & mask_].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // The last item, race with the thieves
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                    std::memory_order_relaxed))
+            {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread, returns null if the deque is empty or another thread won the item
+    T *steal()
+    {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return nullptr;
+        }
+
+        T *item = items_[t & mask_].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Approximate if other threads use the deque
+    int getSize() const
+    {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? (int)(b - t) : 0;
+    }
+
+private:
+    // Separate cache lines, the owner writes the bottom and the thieves write the top
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+
+    const int64_t mask_;
+    std::vector<std::atomic<T *>> items_;
+};
+
+} // namespace tbb
@@ -15,15 +15,23 @@ public:
     };
 
 public:
+    explicit WorkerThread(int index)
+        : index_(index)
+    {}
+
     void execute() override;
 
     State getState() const;
 
+    // Index of the worker in the job queue
+    int getIndex() const { return index_; }
+
 private:
     void set_state(State state);
 
 private:
-    std::atomic<int> state_;
+    const int index_;
+    std::atomic<int> state_{0};
 };
 
 } // namespace tbb
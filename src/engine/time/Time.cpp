@@ -6,6 +6,8 @@
     #include <Windows.h>
 
     #include <cassert>
+#else
+    #include <sys/time.h>
 #endif
 
 namespace
@@ -5,6 +5,10 @@
 class Time
 {
 public:
+    // Owned by the Engine, the headless tools create their own
+    Time();
+    ~Time();
+
     [[nodiscard]] uint64_t getTimeUsec() const;
     [[nodiscard]] double getTime() const;
 
@@ -16,9 +20,6 @@ public:
     [[nodiscard]] double getFps() const { return fps_; }
 
 private:
-    Time();
-    ~Time();
-
     friend class Engine;
     void update();
 
@@ -0,0 +1,210 @@
+#include "Lz.h"
+
+#include "Base.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+constexpr int MIN_MATCH = 4;
+constexpr int MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+
+// Skip faster through the data which doesn't compress
+constexpr int SKIP_SHIFT = 6;
+
+REALENGINE_INLINE uint32_t read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+REALENGINE_INLINE uint32_t hash32(uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+REALENGINE_INLINE void write_length(std::vector<uint8_t> &out, uint64_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((uint8_t)length);
+}
+
+REALENGINE_INLINE bool read_length(const uint8_t *&ip, const uint8_t *end, uint64_t &length)
+{
+    uint8_t byte;
+    do
+    {
+        if (ip == end)
+        {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void write_sequence(std::vector<uint8_t> &out, const uint8_t *literals, uint64_t num_literals,
+    uint32_t offset, uint64_t match_length)
+{
+    const uint64_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    const uint8_t token = (uint8_t)((std::min<uint64_t>(num_literals, 15) << 4)
+        | std::min<uint64_t>(match_code, 15));
+    out.push_back(token);
+    if (num_literals >= 15)
+    {
+        write_length(out, num_literals - 15);
+    }
+    out.insert(out.end(), literals, literals + num_literals);
+
+    if (match_length == 0)
+    {
+        return;
+    }
+    out.push_back((uint8_t)offset);
+    out.push_back((uint8_t)(offset >> 8));
+    if (match_code >= 15)
+    {
+        write_length(out, match_code - 15);
+    }
+}
+
+} // namespace
+
+namespace Lz
+{
+
+void compress(const uint8_t *src, uint64_t size, std::vector<uint8_t> &out)
+{
+    uint32_t table[1 << HASH_BITS] = {};
+
+    uint64_t anchor = 0;
+    uint64_t ip = 1;
+    while (size >= MIN_MATCH && ip + MIN_MATCH <= size)
+    {
+        // Find a match
+        uint64_t ref = 0;
+        bool found = false;
+        while (ip + MIN_MATCH <= size)
+        {
+            const uint32_t sequence = read32(src + ip);
+            const uint32_t h = hash32(sequence);
+            ref = table[h];
+            table[h] = (uint32_t)ip;
+            if (ip - ref <= MAX_OFFSET && ref < ip && read32(src + ref) == sequence)
+            {
+                found = true;
+                break;
+            }
+            ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+        }
+        if (!found)
+        {
+            break;
+        }
+
+        // Extend the match backward and forward
+        while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+        {
+            --ip;
+            --ref;
+        }
+        uint64_t length = MIN_MATCH;
+        while (ip + length < size && src[ref + length] == src[ip + length])
+        {
+            ++length;
+        }
+
+        write_sequence(out, src + anchor, ip - anchor, (uint32_t)(ip - ref), length);
+        ip += length;
+        anchor = ip;
+
+        if (ip + MIN_MATCH <= size)
+        {
+            table[hash32(read32(src + ip - 2))] = (uint32_t)(ip - 2);
+        }
+    }
+
+    // The last sequence has only literals
+    write_sequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool decompress(const uint8_t *src, uint64_t size, uint8_t *dst, uint64_t dst_size)
+{
+    const uint8_t *ip = src;
+    const uint8_t *const end = src + size;
+    uint8_t *op = dst;
+    uint8_t *const dst_end = dst + dst_size;
+
+    while (ip < end)
+    {
+        const uint8_t token = *ip++;
+
+        uint64_t num_literals = token >> 4;
+        if (num_literals == 15 && !read_length(ip, end, num_literals))
+        {
+            return false;
+        }
+        if (num_literals > (uint64_t)(end - ip) || num_literals > (uint64_t)(dst_end - op))
+        {
+            return false;
+        }
+        memcpy(op, ip, num_literals);
+        ip += num_literals;
+        op += num_literals;
+
+        if (ip == end)
+        {
+            break;
+        }
+
+        if (end - ip < 2)
+        {
+            return false;
+        }
+        const uint64_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint64_t)(op - dst))
+        {
+            return false;
+        }
+
+        uint64_t length = token & 15;
+        if (length == 15 && !read_length(ip, end, length))
+        {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (length > (uint64_t)(dst_end - op))
+        {
+            return false;
+        }
+
+        const uint8_t *match = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op, match, length);
+        }
+        else
+        {
+            // Overlapped copy repeats the last offset bytes
+            for (uint64_t i = 0; i < length; ++i)
+            {
+                op[i] = match[i];
+            }
+        }
+        op += length;
+    }
+
+    return op == dst_end;
+}
+
+} // namespace Lz
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// LZ4-like byte compressor: sequences of literals followed by a back reference (16-bit offset,
+// >= 4 bytes). Fast, not compatible with the LZ4 block format
+namespace Lz
+{
+
+// Appends the compressed data to the buffer
+void compress(const uint8_t *src, uint64_t size, std::vector<uint8_t> &out);
+
+// The decompressed size must be known, returns false if the data is invalid
+bool decompress(const uint8_t *src, uint64_t size, uint8_t *dst, uint64_t dst_size);
+
+} // namespace Lz
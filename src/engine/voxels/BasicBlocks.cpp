@@ -1,7 +1,75 @@
 #include "BasicBlocks.h"
 
+#include "BlocksRegistry.h"
+
 int BasicBlocks::AIR = -1;
 int BasicBlocks::GRASS = -1;
 int BasicBlocks::DIRT = -1;
 int BasicBlocks::STONE = -1;
 int BasicBlocks::SNOW = -1;
+
+void BasicBlocks::registerBlocks(BlocksRegistry &registry)
+{
+    {
+        BlockDescription &b = registry.addBlock();
+        AIR = b.id;
+        b.name = "Air";
+        b.type = BlockType::AIR;
+        b.texture_index_px = 0;
+        b.texture_index_nx = 0;
+        b.texture_index_py = 0;
+        b.texture_index_ny = 0;
+        b.texture_index_pz = 0;
+        b.texture_index_nz = 0;
+    }
+    {
+        BlockDescription &b = registry.addBlock();
+        DIRT = b.id;
+        b.name = "Dirt";
+        b.type = BlockType::SOLID;
+        b.texture_index_px = 2;
+        b.texture_index_nx = 2;
+        b.texture_index_py = 2;
+        b.texture_index_ny = 2;
+        b.texture_index_pz = 2;
+        b.texture_index_nz = 2;
+    }
+    {
+        BlockDescription &b = registry.addBlock();
+        GRASS = b.id;
+        b.name = "Grass";
+        b.type = BlockType::SOLID;
+        b.texture_index_px = 1;
+        b.texture_index_nx = 1;
+        b.texture_index_py = 0;
+        b.texture_index_ny = 2;
+        b.texture_index_pz = 1;
+        b.texture_index_nz = 1;
+    }
+    {
+        BlockDescription &b = registry.addBlock();
+        STONE = b.id;
+        b.name = "Stone";
+        b.type = BlockType::SOLID;
+        b.texture_index_px = 3;
+        b.texture_index_nx = 3;
+        b.texture_index_py = 3;
+        b.texture_index_ny = 3;
+        b.texture_index_pz = 3;
+        b.texture_index_nz = 3;
+    }
+    {
+        BlockDescription &b = registry.addBlock();
+        SNOW = b.id;
+        b.name = "Snow";
+        b.type = BlockType::SOLID;
+        b.texture_index_px = 4;
+        b.texture_index_nx = 4;
+        b.texture_index_py = 4;
+        b.texture_index_ny = 4;
+        b.texture_index_pz = 4;
+        b.texture_index_nz = 4;
+    }
+
+    assert(AIR == 0);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+class BlocksRegistry;
+
 namespace BasicBlocks
 {
 
@@ -9,4 +11,7 @@ extern int DIRT;
 extern int STONE;
 extern int SNOW;
 
+// Adds the blocks to the empty registry and sets the ids above
+void registerBlocks(BlocksRegistry &registry);
+
 } // namespace BasicBlocks
@@ -2,7 +2,6 @@
 
 #include "Base.h"
 
-#include <glm/vec2.hpp>
 #include <string>
 
 enum class BlockType
@@ -43,32 +42,4 @@ public:
             int texture_index_nz;
         };
     };
-
-    /////////////////////////////////////////////////////////
-
-    struct TexCoords
-    {
-        glm::vec2 bottom_left;
-        glm::vec2 bottom_right;
-        glm::vec2 top_left;
-        glm::vec2 top_right;
-    };
-
-    struct Cached
-    {
-        bool valid{false};
-        union
-        {
-            TexCoords texture_coords[6];
-            struct
-            {
-                TexCoords texture_coord_px;
-                TexCoords texture_coord_nx;
-                TexCoords texture_coord_py;
-                TexCoords texture_coord_ny;
-                TexCoords texture_coord_pz;
-                TexCoords texture_coord_nz;
-            };
-        };
-    } cached;
 };
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include "Base.h"
 #include "BlockDescription.h"
+#include "ChunkSection.h"
+
+#include <glm/vec2.hpp>
 
 #include <vector>
 
@@ -33,15 +36,22 @@ public:
     }
 
     REALENGINE_INLINE const BlockDescription &getBlock(int id) const { return blocks_[id]; }
+    REALENGINE_INLINE int getNumBlocks() const { return blocks_.size(); }
+
+    // Uniform section of a non-air block, hides all faces of the neighbour sections
+    REALENGINE_INLINE bool isSolidSection(const ChunkSection &section) const
+    {
+        return section.getState() == ChunkSection::State::Uniform
+            && getBlock(section.getUniformBlock().id).type != BlockType::AIR;
+    }
 
     void setAtlas(Texture *texture, glm::ivec2 block_size);
 
     REALENGINE_INLINE Texture *getAtlas() const { return atlas_; }
 
-    void flush();
-
-private:
-    void invalidate();
+    // Size of one block texture in the atlas coordinates
+    REALENGINE_INLINE glm::vec2 getAtlasTileSize() const { return block_size_ * factor_; }
+    REALENGINE_INLINE int getAtlasTilesPerRow() const { return num_atlas_blocks_.x; }
 
 private:
     Texture *atlas_{};
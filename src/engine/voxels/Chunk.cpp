@@ -1,7 +1,5 @@
 #include "Chunk.h"
 
-#include "ChunkMesh.h"
-
 #include <cmath>
 
 float Chunk::BOUND_SPHERE_RADIUS = std::sqrt((float)CHUNK_WIDTH2 * 2 + (float)CHUNK_HEIGHT2);
@@ -17,10 +15,48 @@ Chunk::~Chunk() = default;
 
 void Chunk::clear()
 {
-    for (BlockInfo &b : blocks_)
+    for (ChunkSection &section : sections_)
+    {
+        if (!section.isEmpty())
+        {
+            section.fill(BlockInfo{0});
+        }
+    }
+    dirty_sections_ = 0;
+    modified_ = false;
+}
+
+void Chunk::getBlocks(BlockInfo *out_blocks) const
+{
+    for (const ChunkSection &section : sections_)
+    {
+        section.getBlocks(out_blocks);
+        out_blocks += SECTION_NUM_BLOCKS;
+    }
+}
+
+void Chunk::fillSection(int index, BlockInfo block)
+{
+    assert(index >= 0 && index < NUM_SECTIONS);
+    sections_[index].fill(block);
+    dirty_sections_ |= 1u << index;
+}
+
+void Chunk::setSectionBlocks(int index, const BlockInfo *blocks)
+{
+    assert(index >= 0 && index < NUM_SECTIONS);
+    sections_[index].setBlocks(blocks);
+    dirty_sections_ |= 1u << index;
+}
+
+uint64_t Chunk::getMemoryUsage() const
+{
+    uint64_t memory = sizeof(Chunk) - sizeof(sections_);
+    for (const ChunkSection &section : sections_)
     {
-        b.id = 0;
+        memory += section.getMemoryUsage();
     }
+    return memory;
 }
 
 void Chunk::update_values()
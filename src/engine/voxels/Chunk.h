@@ -2,15 +2,14 @@
 
 #include "Base.h"
 #include "BlockInfo.h"
-#include "VertexBufferObject.h"
+#include "ChunkSection.h"
 #include "math/BoundSphere.h"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 
-struct ChunkMesh;
+class ChunkMesh;
 struct BlockDescription;
-class VertexArrayObject;
 
 // Blocks order in memory: XZY
 struct Chunk
@@ -27,6 +26,19 @@ public:
 
     static constexpr int NUM_BLOCKS = CHUNK_WIDTH2 * CHUNK_HEIGHT;
 
+    static constexpr int SECTION_HEIGHT = ChunkSection::HEIGHT;
+    static constexpr int NUM_SECTIONS = CHUNK_HEIGHT / SECTION_HEIGHT;
+    static constexpr int SECTION_NUM_BLOCKS = ChunkSection::NUM_BLOCKS;
+
+    // Block index in XZY order is the section index followed by the index inside the section
+    static constexpr int SECTION_INDEX_SHIFT = 12;
+    static constexpr int SECTION_INDEX_MASK = SECTION_NUM_BLOCKS - 1;
+
+    static_assert(ChunkSection::WIDTH == CHUNK_WIDTH, "Invalid section width");
+    static_assert(CHUNK_HEIGHT % SECTION_HEIGHT == 0, "Invalid section height");
+    static_assert(SECTION_NUM_BLOCKS == 1 << SECTION_INDEX_SHIFT, "Invalid section index shift");
+    static_assert(NUM_SECTIONS <= 32, "Dirty sections don't fit the mask");
+
     // TODO: constexpr!
     static float BOUND_SPHERE_RADIUS;
 
@@ -55,36 +67,105 @@ public:
         return x >= 0 && x < CHUNK_WIDTH && y >= 0 && y < CHUNK_HEIGHT && z >= 0 && z < CHUNK_WIDTH;
     }
 
-    REALENGINE_INLINE BlockInfo &getBlockRef(int index)
+    // Blocks are stored in a paletted storage, so there is no real reference to a block
+    class BlockRef
+    {
+    public:
+        BlockRef(Chunk &chunk, int index)
+            : chunk_(chunk)
+            , index_(index)
+        {}
+
+        REALENGINE_INLINE operator BlockInfo() const { return chunk_.getBlock(index_); }
+
+        REALENGINE_INLINE BlockRef &operator=(BlockInfo block)
+        {
+            chunk_.setBlock(index_, block);
+            return *this;
+        }
+
+        REALENGINE_INLINE BlockRef &operator=(const BlockRef &other)
+        {
+            return *this = BlockInfo(other);
+        }
+
+        friend bool operator==(const BlockRef &lhs, BlockInfo rhs) { return BlockInfo(lhs) == rhs; }
+        friend bool operator!=(const BlockRef &lhs, BlockInfo rhs) { return BlockInfo(lhs) != rhs; }
+
+    private:
+        Chunk &chunk_;
+        int index_;
+    };
+
+    REALENGINE_INLINE BlockRef getBlockRef(int index)
     {
         assert(index >= 0 && index < NUM_BLOCKS);
-        return blocks_[index];
+        return BlockRef(*this, index);
     }
 
     REALENGINE_INLINE BlockInfo getBlock(int index) const
     {
         assert(index >= 0 && index < NUM_BLOCKS);
-        return blocks_[index];
+        return sections_[index >> SECTION_INDEX_SHIFT].getBlock(index & SECTION_INDEX_MASK);
     }
 
-    REALENGINE_INLINE BlockInfo &getBlockRef(int x, int y, int z)
+    REALENGINE_INLINE BlockRef getBlockRef(int x, int y, int z)
     {
         assert(isInsideChunk(x, y, z));
-        return blocks_[getBlockIndex(x, y, z)];
+        return BlockRef(*this, getBlockIndex(x, y, z));
     }
 
     REALENGINE_INLINE BlockInfo getBlock(int x, int y, int z) const
     {
         assert(isInsideChunk(x, y, z));
-        return blocks_[getBlockIndex(x, y, z)];
+        return getBlock(getBlockIndex(x, y, z));
+    }
+
+    REALENGINE_INLINE void setBlock(int index, const BlockInfo &block)
+    {
+        assert(index >= 0 && index < NUM_BLOCKS);
+        const int section_index = index >> SECTION_INDEX_SHIFT;
+        sections_[section_index].setBlock(index & SECTION_INDEX_MASK, block);
+        dirty_sections_ |= 1u << section_index;
     }
 
     REALENGINE_INLINE void setBlock(int x, int y, int z, const BlockInfo &block)
     {
         assert(isInsideChunk(x, y, z));
-        blocks_[getBlockIndex(x, y, z)] = block;
+        setBlock(getBlockIndex(x, y, z), block);
     }
 
+    // Decode all blocks to the flat array of NUM_BLOCKS elements (XZY order)
+    void getBlocks(BlockInfo *out_blocks) const;
+
+    REALENGINE_INLINE const ChunkSection &getSection(int index) const
+    {
+        assert(index >= 0 && index < NUM_SECTIONS);
+        return sections_[index];
+    }
+
+    REALENGINE_INLINE ChunkSection::State getSectionState(int index) const
+    {
+        return getSection(index).getState();
+    }
+
+    static REALENGINE_INLINE int getSectionIndex(int y)
+    {
+        assert(y >= 0 && y < CHUNK_HEIGHT);
+        return y / SECTION_HEIGHT;
+    }
+
+    void fillSection(int index, BlockInfo block);
+    // SECTION_NUM_BLOCKS blocks in XZY order
+    void setSectionBlocks(int index, const BlockInfo *blocks);
+
+    // Sections changed since the last clearDirtySections(), bit per section
+    uint32_t getDirtySections() const { return dirty_sections_; }
+    bool isSectionDirty(int index) const { return (dirty_sections_ >> index) & 1u; }
+    void clearDirtySections() { dirty_sections_ = 0; }
+
+    uint64_t getMemoryUsage() const;
+
     static REALENGINE_INLINE int getBlockIndex(int x, int y, int z)
     {
         assert(isInsideChunk(x, y, z));
@@ -179,14 +260,16 @@ private:
     void update_values();
 
 public:
-    BlockInfo blocks_[NUM_BLOCKS];
-
     // TODO: rename this class to ChunkData and move this fields to Chunk
     bool need_rebuild_mesh_{true};
     bool need_rebuild_mesh_force_{false};
-    UPtr<ChunkMesh> mesh_; // could be null
+    bool modified_{false}; // changed since the generation or the last save
+    ChunkMesh *mesh_{}; // could be null, owned by VoxelEngine
 
 private:
+    ChunkSection sections_[NUM_SECTIONS];
+    uint32_t dirty_sections_{0};
+
     glm::ivec3 position_{0, 0, 0};
     math::BoundSphere bound_sphere_;
 };
@@ -196,16 +279,33 @@ private:
 template<typename F>
 void Chunk::visitRead(F &&func) const
 {
-    int block_index = -1;
-    for (int y = 0; y < CHUNK_HEIGHT; ++y)
+    BlockInfo section_blocks[SECTION_NUM_BLOCKS];
+    for (int section_index = 0; section_index < NUM_SECTIONS; ++section_index)
     {
-        for (int z = 0; z < CHUNK_WIDTH; ++z)
+        const ChunkSection &section = sections_[section_index];
+        const bool uniform = section.isUniform();
+        BlockInfo uniform_block;
+        if (uniform)
         {
-            for (int x = 0; x < CHUNK_WIDTH; ++x)
+            uniform_block = section.getUniformBlock();
+        }
+        else
+        {
+            section.getBlocks(section_blocks);
+        }
+
+        const int y_begin = section_index * SECTION_HEIGHT;
+        int block_index = -1;
+        for (int y = y_begin; y < y_begin + SECTION_HEIGHT; ++y)
+        {
+            for (int z = 0; z < CHUNK_WIDTH; ++z)
             {
-                ++block_index;
-                const BlockInfo &b = blocks_[block_index];
-                func(x, y, z, b);
+                for (int x = 0; x < CHUNK_WIDTH; ++x)
+                {
+                    ++block_index;
+                    const BlockInfo b = uniform ? uniform_block : section_blocks[block_index];
+                    func(x, y, z, b);
+                }
             }
         }
     }
@@ -230,8 +330,13 @@ void Chunk::visitWrite(F &&func, bool force)
             for (int x = 0; x < CHUNK_WIDTH; ++x)
             {
                 ++block_index;
-                BlockInfo &b = blocks_[block_index];
+                const BlockInfo old_b = getBlock(block_index);
+                BlockInfo b = old_b;
                 func(x, y, z, b);
+                if (b != old_b)
+                {
+                    setBlock(block_index, b);
+                }
             }
         }
     }
@@ -240,51 +345,18 @@ void Chunk::visitWrite(F &&func, bool force)
 template<typename F>
 void Chunk::visitReadGlobal(F &&func) const
 {
-    int block_index = -1;
-    const auto x_begin = position_.x * CHUNK_WIDTH;
-    const auto x_end = x_begin + CHUNK_WIDTH;
-    const auto z_begin = position_.z * CHUNK_WIDTH;
-    const auto z_end = z_begin + CHUNK_WIDTH;
-    for (int y = 0; y < CHUNK_HEIGHT; ++y)
-    {
-        for (int z = z_begin; z < z_end; ++z)
-        {
-            for (int x = x_begin; x < x_end; ++x)
-            {
-                ++block_index;
-                const BlockInfo &b = blocks_[block_index];
-                func(x, y, z, b);
-            }
-        }
-    }
+    const int x_offset = position_.x * CHUNK_WIDTH;
+    const int z_offset = position_.z * CHUNK_WIDTH;
+    visitRead([&](int x, int y, int z, const BlockInfo &b) {
+        func(x + x_offset, y, z + z_offset, b);
+    });
 }
 
 template<typename F>
 void Chunk::visitWriteGlobal(F &&func, bool force)
 {
-    if (force)
-    {
-        need_rebuild_mesh_force_ = true;
-    }
-    else
-    {
-        need_rebuild_mesh_ = true;
-    }
-    int block_index = -1;
-    const auto x_begin = position_.x * CHUNK_WIDTH;
-    const auto x_end = x_begin + CHUNK_WIDTH;
-    const auto z_begin = position_.z * CHUNK_WIDTH;
-    const auto z_end = z_begin + CHUNK_WIDTH;
-    for (int y = 0; y < CHUNK_HEIGHT; ++y)
-    {
-        for (int z = z_begin; z < z_end; ++z)
-        {
-            for (int x = x_begin; x < x_end; ++x)
-            {
-                ++block_index;
-                BlockInfo &b = blocks_[block_index];
-                func(x, y, z, b);
-            }
-        }
-    }
+    const int x_offset = position_.x * CHUNK_WIDTH;
+    const int z_offset = position_.z * CHUNK_WIDTH;
+    visitWrite([&](int x, int y, int z, BlockInfo &b) { func(x + x_offset, y, z + z_offset, b); },
+        force);
 }
@@ -0,0 +1,186 @@
+#include "ChunkCodec.h"
+
+#include "Chunk.h"
+#include "profiler/ScopedProfiler.h"
+#include "utils/Lz.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Every block in its own run, an id and a length of 5 bytes at most
+constexpr uint32_t MAX_RUNS_SIZE = (uint32_t)Chunk::NUM_BLOCKS * 2 * 5;
+
+REALENGINE_INLINE void write_varint(std::vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+REALENGINE_INLINE bool read_varint(const uint8_t *&data, const uint8_t *end, uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7)
+    {
+        if (data == end)
+        {
+            return false;
+        }
+        const uint8_t byte = *data++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run of the same block ids, the length is stored minus one
+struct RunWriter
+{
+    explicit RunWriter(std::vector<uint8_t> &out)
+        : out(out)
+    {}
+
+    REALENGINE_INLINE void add(BlockInfo block, uint32_t count)
+    {
+        if (length > 0 && block == run_block)
+        {
+            length += count;
+            return;
+        }
+        flush();
+        run_block = block;
+        length = count;
+    }
+
+    void flush()
+    {
+        if (length == 0)
+        {
+            return;
+        }
+        write_varint(out, (uint32_t)run_block.id);
+        write_varint(out, length - 1);
+        length = 0;
+    }
+
+    std::vector<uint8_t> &out;
+    BlockInfo run_block;
+    uint32_t length{0};
+};
+
+void encode_runs(const Chunk &chunk, std::vector<uint8_t> &out)
+{
+    RunWriter writer(out);
+    BlockInfo blocks[Chunk::SECTION_NUM_BLOCKS];
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        const ChunkSection &section = chunk.getSection(section_index);
+        if (section.isUniform())
+        {
+            writer.add(section.getUniformBlock(), Chunk::SECTION_NUM_BLOCKS);
+            continue;
+        }
+        section.getBlocks(blocks);
+        for (const BlockInfo &block : blocks)
+        {
+            writer.add(block, 1);
+        }
+    }
+    writer.flush();
+}
+
+bool decode_runs(const uint8_t *data, const uint8_t *end, int num_block_ids, Chunk &chunk)
+{
+    BlockInfo blocks[Chunk::SECTION_NUM_BLOCKS];
+    BlockInfo run_block;
+    uint32_t run_left = 0;
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        bool filled = false;
+        int index = 0;
+        while (index < Chunk::SECTION_NUM_BLOCKS)
+        {
+            if (run_left == 0)
+            {
+                uint32_t id = 0;
+                uint32_t length = 0;
+                if (!read_varint(data, end, id) || !read_varint(data, end, length)
+                    || id >= (uint32_t)num_block_ids || length >= (uint32_t)Chunk::NUM_BLOCKS)
+                {
+                    return false;
+                }
+                run_block = BlockInfo{(int)id};
+                run_left = length + 1;
+            }
+
+            // Whole section in one run
+            if (index == 0 && run_left >= (uint32_t)Chunk::SECTION_NUM_BLOCKS)
+            {
+                chunk.fillSection(section_index, run_block);
+                run_left -= Chunk::SECTION_NUM_BLOCKS;
+                filled = true;
+                break;
+            }
+
+            const int count = (int)std::min<uint32_t>(run_left, Chunk::SECTION_NUM_BLOCKS - index);
+            std::fill(blocks + index, blocks + index + count, run_block);
+            index += count;
+            run_left -= count;
+        }
+        if (!filled)
+        {
+            chunk.setSectionBlocks(section_index, blocks);
+        }
+    }
+    return run_left == 0 && data == end;
+}
+
+} // namespace
+
+namespace ChunkCodec
+{
+
+void encode(const Chunk &chunk, std::vector<uint8_t> &out)
+{
+    SCOPED_FUNC_PROFILER;
+
+    static thread_local std::vector<uint8_t> runs;
+    runs.clear();
+    encode_runs(chunk, runs);
+
+    write_varint(out, (uint32_t)runs.size());
+    Lz::compress(runs.data(), runs.size(), out);
+}
+
+bool decode(const uint8_t *data, uint64_t size, int num_block_ids, Chunk &chunk)
+{
+    SCOPED_FUNC_PROFILER;
+
+    const uint8_t *end = data + size;
+    uint32_t runs_size = 0;
+    if (!read_varint(data, end, runs_size) || runs_size > MAX_RUNS_SIZE)
+    {
+        chunk.clear();
+        return false;
+    }
+
+    static thread_local std::vector<uint8_t> runs;
+    runs.resize(runs_size);
+    if (!Lz::decompress(data, end - data, runs.data(), runs_size)
+        || !decode_runs(runs.data(), runs.data() + runs_size, num_block_ids, chunk))
+    {
+        chunk.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace ChunkCodec
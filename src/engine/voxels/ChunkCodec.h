@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct Chunk;
+
+// Compact encoding of the chunk blocks: runs of block ids in XZY order (varints), compressed
+// with Lz. The position and the other chunk state aren't stored
+namespace ChunkCodec
+{
+
+// Appends the encoded blocks to the buffer
+void encode(const Chunk &chunk, std::vector<uint8_t> &out);
+
+// The chunk is cleared if the data is invalid or has block ids out of [0, num_block_ids)
+bool decode(const uint8_t *data, uint64_t size, int num_block_ids, Chunk &chunk);
+
+} // namespace ChunkCodec
@@ -0,0 +1,144 @@
+#include "ChunkIO.h"
+
+#include "Chunk.h"
+#include "ChunkCodec.h"
+#include "profiler/ScopedProfiler.h"
+#include "threads/Thread.h"
+
+class ChunkIOThread final : public Thread
+{
+public:
+    explicit ChunkIOThread(ChunkIO &io)
+        : io_(io)
+    {}
+
+    void execute() override { io_.execute_thread(*this); }
+
+private:
+    ChunkIO &io_;
+};
+
+ChunkIO::ChunkIO()
+{
+    thread_ = makeU<ChunkIOThread>(*this);
+    thread_->setName("Chunk IO");
+    thread_->start();
+}
+
+ChunkIO::~ChunkIO()
+{
+    {
+        std::lock_guard lock(requests_mutex_);
+        thread_->exit();
+    }
+    requests_cv_.notify_one();
+    thread_->join();
+}
+
+void ChunkIO::enqueueSave(const std::shared_ptr<RegionStorage> &storage, const Chunk &chunk)
+{
+    SCOPED_FUNC_PROFILER;
+    assert(storage);
+
+    const glm::ivec2 pos = chunk.getPositionXZ();
+    std::vector<uint8_t> data;
+    ChunkCodec::encode(chunk, data);
+
+    {
+        std::lock_guard lock(requests_mutex_);
+        const auto it = save_indices_.find(pos);
+        if (it != save_indices_.end() && saves_[it->second].storage == storage)
+        {
+            saves_[it->second].chunk.data = std::move(data);
+            return;
+        }
+        save_indices_[pos] = (int)saves_.size();
+        saves_.push_back({storage, {pos, std::move(data)}});
+        ++queue_depth_;
+    }
+    requests_cv_.notify_one();
+}
+
+void ChunkIO::enqueueLoad(const std::shared_ptr<RegionStorage> &storage, UPtr<Chunk> chunk)
+{
+    assert(storage);
+    assert(chunk);
+    {
+        std::lock_guard lock(requests_mutex_);
+        loads_.push_back({storage, std::move(chunk)});
+        ++queue_depth_;
+    }
+    requests_cv_.notify_one();
+}
+
+void ChunkIO::takeLoadResults(std::vector<LoadResult> &out_results)
+{
+    std::lock_guard lock(results_mutex_);
+    for (LoadResult &result : results_)
+    {
+        out_results.push_back(std::move(result));
+    }
+    results_.clear();
+}
+
+void ChunkIO::execute_thread(const ChunkIOThread &thread)
+{
+    std::vector<SaveRequest> saves;
+    std::vector<LoadRequest> loads;
+    while (true)
+    {
+        {
+            std::unique_lock lock(requests_mutex_);
+            requests_cv_.wait(lock,
+                [&] { return thread.needExit() || !saves_.empty() || !loads_.empty(); });
+
+            // Taken together, so the saves enqueued before a load are written before it
+            std::swap(saves, saves_);
+            std::swap(loads, loads_);
+            save_indices_.clear();
+        }
+
+        if (thread.needExit())
+        {
+            loads.clear();
+            process_requests(saves, loads);
+            break;
+        }
+        process_requests(saves, loads);
+    }
+}
+
+void ChunkIO::process_requests(std::vector<SaveRequest> &saves, std::vector<LoadRequest> &loads)
+{
+    SCOPED_FUNC_PROFILER;
+
+    // Batch per storage, there is only one storage unless the seed has changed
+    std::vector<RegionStorage::ChunkData> batch;
+    for (int begin = 0; begin < (int)saves.size();)
+    {
+        RegionStorage *storage = saves[begin].storage.get();
+        int end = begin;
+        batch.clear();
+        for (; end < (int)saves.size() && saves[end].storage.get() == storage; ++end)
+        {
+            batch.push_back(std::move(saves[end].chunk));
+        }
+        bytes_written_ += storage->saveChunks(batch);
+        queue_depth_ -= end - begin;
+        begin = end;
+    }
+    saves.clear();
+
+    for (LoadRequest &request : loads)
+    {
+        uint64_t bytes_read = 0;
+        const bool loaded = request.storage->loadChunk(*request.chunk, bytes_read);
+        bytes_read_ += bytes_read;
+        {
+            std::lock_guard lock(results_mutex_);
+            results_.push_back({std::move(request.chunk), loaded});
+        }
+        --queue_depth_;
+    }
+    loads.clear();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Base.h"
+#include "RegionStorage.h"
+#include "utils/Hashers.h"
+
+#include "glm/vec2.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct Chunk;
+class ChunkIOThread;
+
+// Chunk saves/loads served by a dedicated thread, so the disk latency doesn't block the main
+// thread and the generation workers. Repeated saves of a chunk are coalesced, all pending saves
+// are written in one batch before the pending loads, so a load always sees the previous saves.
+class ChunkIO
+{
+public:
+    struct LoadResult
+    {
+        UPtr<Chunk> chunk;
+        bool loaded{false}; // false - the chunk isn't stored, it's still cleared
+    };
+
+public:
+    ChunkIO();
+    // The pending saves are written, the pending loads are dropped
+    ~ChunkIO();
+
+    REMOVE_COPY_MOVE_CLASS(ChunkIO);
+
+    // The chunk is encoded immediately, it can be changed or released after the call
+    void enqueueSave(const std::shared_ptr<RegionStorage> &storage, const Chunk &chunk);
+    void enqueueLoad(const std::shared_ptr<RegionStorage> &storage, UPtr<Chunk> chunk);
+
+    // Results in the order of the requests
+    void takeLoadResults(std::vector<LoadResult> &out_results);
+
+    // Saves and loads not finished yet
+    int getQueueDepth() const { return queue_depth_.load(std::memory_order_relaxed); }
+    uint64_t getNumBytesRead() const { return bytes_read_.load(std::memory_order_relaxed); }
+    uint64_t getNumBytesWritten() const { return bytes_written_.load(std::memory_order_relaxed); }
+
+private:
+    friend class ChunkIOThread;
+
+    struct SaveRequest
+    {
+        std::shared_ptr<RegionStorage> storage;
+        RegionStorage::ChunkData chunk;
+    };
+
+    struct LoadRequest
+    {
+        std::shared_ptr<RegionStorage> storage;
+        UPtr<Chunk> chunk;
+    };
+
+    void execute_thread(const ChunkIOThread &thread);
+    void process_requests(std::vector<SaveRequest> &saves, std::vector<LoadRequest> &loads);
+
+private:
+    std::mutex requests_mutex_;
+    std::condition_variable requests_cv_;
+    std::vector<SaveRequest> saves_;
+    std::unordered_map<glm::ivec2, int> save_indices_; // saves_ index by the chunk position
+    std::vector<LoadRequest> loads_;
+
+    std::mutex results_mutex_;
+    std::vector<LoadResult> results_;
+
+    std::atomic<int> queue_depth_{0};
+    std::atomic<uint64_t> bytes_read_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+
+    // Must be the last one, the thread uses the members above
+    UPtr<ChunkIOThread> thread_;
+};
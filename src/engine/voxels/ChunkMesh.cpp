@@ -3,10 +3,8 @@
 ChunkMesh::ChunkMesh()
 {
     vao.bind();
-    vao.addAttributeFloat(3); // pos
-    vao.addAttributeFloat(3); // norm
-    vao.addAttributeFloat(2); // uv
-    vao.addAttributeFloat(1); // ao
+    vao.addAttributeUint(1); // data0
+    vao.addAttributeUint(1); // data1
 
     vbo.bind();
 
@@ -1,36 +1,27 @@
 #pragma once
 
 #include "Base.h"
+#include "ChunkMeshData.h"
 #include "VertexArrayObject.h"
 #include "VertexBufferObject.h"
 
-#include <glm/vec2.hpp>
-#include <glm/vec3.hpp>
-
+// GPU buffers of a chunk mesh, main thread only. No vertices are kept on the CPU side, they are
+// built to a ChunkMeshData and uploaded
 class ChunkMesh
 {
 public:
-    struct Vertex
-    {
-        glm::vec3 pos;
-        glm::vec3 norm;
-        glm::vec2 uv;
-        float ao;
-    };
+    using Vertex = ChunkMeshData::Vertex;
 
     ChunkMesh();
 
     REALENGINE_INLINE void bind() const { vao.bind(); }
-    REALENGINE_INLINE int getNumCpuVertices() const { return vbo.getNumCpuVertices(); }
     REALENGINE_INLINE int getNumGpuVertices() const { return vbo.getNumGpuVertices(); }
-    REALENGINE_INLINE void clear() { vbo.clear(); }
-    REALENGINE_INLINE void deallocate() { vbo.deallocate(); }
-    REALENGINE_INLINE void flush() { vbo.flush(true); }
-    REALENGINE_INLINE int addVertex(const Vertex &v) { return vbo.addVertex(v); }
-    REALENGINE_INLINE void addRaw(const void *data, int size_bytes)
+    REALENGINE_INLINE void upload(const ChunkMeshData &data)
     {
-        vbo.addRaw(data, size_bytes);
+        vbo.flush(data.getVertices().data(), data.getNumVertices(), true);
     }
+    // Drop the vertices of the previous chunk, a reused mesh is drawn before its rebuild finishes
+    REALENGINE_INLINE void reset() { vbo.flush(nullptr, 0, true); }
 
 private:
     VertexArrayObject vao;
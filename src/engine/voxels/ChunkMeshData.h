@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Base.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+// CPU side geometry of a chunk mesh. Doesn't touch GL, so it's built in the worker threads (or
+// without a context at all) and uploaded to a ChunkMesh on the main thread. clear() keeps the
+// capacity, the buffers are pooled and reused for the next builds
+class ChunkMeshData
+{
+public:
+    // Same order as BlockDescription::texture_indexes
+    enum Face
+    {
+        FACE_PX = 0,
+        FACE_NX,
+        FACE_PY,
+        FACE_NY,
+        FACE_PZ,
+        FACE_NZ,
+    };
+
+    // Packed vertex, decoded in vox.shader
+    // data0: x (5 bits), y (10 bits), z (5 bits), face (3 bits), ao (2 bits)
+    // data1: u (5 bits), v (5 bits), atlas tile index (16 bits)
+    struct Vertex
+    {
+        uint32_t data0;
+        uint32_t data1;
+    };
+    static_assert(sizeof(Vertex) == 8, "Invalid vertex size");
+
+    // pos - local position of the corner in the chunk, uv - texture coordinates in tiles, ao -
+    // number of solid blocks around the corner (0-3)
+    static REALENGINE_INLINE Vertex packVertex(const glm::ivec3 &pos, int face,
+        const glm::ivec2 &uv, int tile, int ao)
+    {
+        assert(pos.x >= 0 && pos.x < 32 && pos.y >= 0 && pos.y < 1024 && pos.z >= 0 && pos.z < 32);
+        assert(face >= 0 && face < 6);
+        assert(uv.x >= 0 && uv.x < 32 && uv.y >= 0 && uv.y < 32);
+        assert(tile >= 0 && tile < (1 << 16));
+        assert(ao >= 0 && ao <= 3);
+        Vertex v;
+        v.data0 = (uint32_t)pos.x | ((uint32_t)pos.y << 5) | ((uint32_t)pos.z << 15)
+            | ((uint32_t)face << 20) | ((uint32_t)ao << 23);
+        v.data1 = (uint32_t)uv.x | ((uint32_t)uv.y << 5) | ((uint32_t)tile << 10);
+        return v;
+    }
+
+    REALENGINE_INLINE void clear() { vertices_.clear(); }
+
+    REALENGINE_INLINE int getNumVertices() const { return (int)vertices_.size(); }
+    REALENGINE_INLINE const std::vector<Vertex> &getVertices() const { return vertices_; }
+    // Appended by ChunkMeshGenerator
+    REALENGINE_INLINE std::vector<Vertex> &getVertices() { return vertices_; }
+
+private:
+    std::vector<Vertex> vertices_;
+};
@@ -3,12 +3,58 @@
 #include "BlockDescription.h"
 #include "BlocksRegistry.h"
 #include "Chunk.h"
-#include "ChunkMesh.h"
-#include "EngineGlobals.h"
-#include "VoxelEngine.h"
-#include "VoxelsUtils.h"
+#include "ChunkMeshData.h"
+#include "ChunkMeshSnapshot.h"
 #include "profiler/ScopedProfiler.h"
 
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// Chunk blocks with one block of padding on each side
+constexpr int PADDED_WIDTH = Chunk::CHUNK_WIDTH + 2;
+constexpr int PADDED_HEIGHT = Chunk::CHUNK_HEIGHT + 2;
+constexpr int PADDED_WIDTH2 = PADDED_WIDTH * PADDED_WIDTH;
+constexpr int PADDED_NUM_BLOCKS = PADDED_WIDTH2 * PADDED_HEIGHT;
+
+// x, y, z are local chunk coordinates, may be -1 or CHUNK_WIDTH/CHUNK_HEIGHT
+REALENGINE_INLINE constexpr int get_padded_index(int x, int y, int z)
+{
+    return (x + 1) + PADDED_WIDTH * (z + 1) + PADDED_WIDTH2 * (y + 1);
+}
+
+// Empty sections don't have faces, as well as solid sections surrounded by solid sections
+bool can_skip_section(const ChunkMeshSnapshot &snapshot, int section_index,
+    const BlocksRegistry &registry)
+{
+    const ChunkSection &section = snapshot.getSection(section_index);
+    if (section.isEmpty())
+    {
+        return true;
+    }
+    if (!registry.isSolidSection(section))
+    {
+        return false;
+    }
+
+    // Nothing above the chunk
+    if (section_index == Chunk::NUM_SECTIONS - 1)
+    {
+        return false;
+    }
+    // -y faces aren't generated for the bottom blocks
+    if (section_index > 0 && !registry.isSolidSection(snapshot.getSection(section_index - 1)))
+    {
+        return false;
+    }
+    return registry.isSolidSection(snapshot.getSection(section_index + 1))
+        && snapshot.isNeighbourSectionsSolid(section_index);
+}
+
+} // namespace
+
 bool is_air(int x, int y, int z, const Descriptions3x3 &descs)
 {
     const BlockDescription *desc = descs.getBlockAtOffset(x, y, z);
@@ -29,350 +75,617 @@ bool is_solid(glm::ivec3 pos, const Descriptions3x3 &descs)
 }
 
 
-void ChunkMeshGenerator::rebuildMesh(const Chunk &chunk, ChunkMesh &mesh,
-    const ExtendedNeighbourChunks &neighbours)
+ChunkMeshGenerator::ChunkMeshGenerator()
 {
-    assert(chunk.need_rebuild_mesh_ || chunk.need_rebuild_mesh_force_);
+    section_blocks_.resize(Chunk::SECTION_NUM_BLOCKS);
+    greedy_mask_.resize(Chunk::CHUNK_WIDTH * Chunk::SECTION_HEIGHT);
+    padded_blocks_.resize(PADDED_NUM_BLOCKS);
+}
 
+void ChunkMeshGenerator::buildMesh(const ChunkMeshSnapshot &snapshot, ChunkMeshData &out_mesh)
+{
     SCOPED_FUNC_PROFILER;
 
-    mesh.clear();
+    out_mesh.clear();
+    std::vector<ChunkMeshData::Vertex> &out_vertices = out_mesh.getVertices();
 
-    BlocksRegistry *registry = eng.vox->getRegistry();
+    fill_padded_blocks(snapshot);
 
-    int block_index = -1;
-    for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+    switch (mode_)
     {
-        for (int z = 0; z < Chunk::CHUNK_WIDTH; ++z)
+    case Mode::Naive: gen_naive(snapshot, out_vertices); break;
+    case Mode::Greedy: gen_greedy(snapshot, out_vertices); break;
+    default: assert(0); break;
+    }
+}
+
+void ChunkMeshGenerator::gen_naive(const ChunkMeshSnapshot &snapshot,
+    std::vector<ChunkMeshData::Vertex> &vertices)
+{
+    SCOPED_FUNC_PROFILER;
+
+    const BlocksRegistry &registry = snapshot.getRegistry();
+
+    int neighbour_offsets[27];
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dz = -1; dz <= 1; ++dz)
         {
-            for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+            for (int dx = -1; dx <= 1; ++dx)
             {
-                ++block_index;
-                const BlockInfo block = chunk.getBlock(block_index);
+                neighbour_offsets[Descriptions3x3::getIndex(dx, dy, dz)] = dx + PADDED_WIDTH * dz
+                    + PADDED_WIDTH2 * dy;
+            }
+        }
+    }
+
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        if (can_skip_section(snapshot, section_index, registry))
+        {
+            continue;
+        }
 
-                if (block.id == 0)
+        const int y_begin = section_index * Chunk::SECTION_HEIGHT;
+        const int y_end = y_begin + Chunk::SECTION_HEIGHT;
+        for (int y = y_begin; y < y_end; ++y)
+        {
+            for (int z = 0; z < Chunk::CHUNK_WIDTH; ++z)
+            {
+                for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
                 {
-                    continue;
-                }
+                    const int padded_index = get_padded_index(x, y, z);
+                    const BlockInfo block = padded_blocks_[padded_index];
+
+                    if (block.id == 0)
+                    {
+                        continue;
+                    }
 
-                const glm::vec3 min = glm::vec3{x, y, z};
-                const glm::vec3 max = min + glm::vec3(1, 1, 1);
+                    const glm::ivec3 min{x, y, z};
+                    const glm::ivec3 max = min + glm::ivec3(1, 1, 1);
 
-                Descriptions3x3 descs;
-                for (int dy = -1; dy <= 1; ++dy)
-                {
-                    for (int dz = -1; dz <= 1; ++dz)
+                    Descriptions3x3 descs;
+                    for (int i = 0; i < 27; ++i)
                     {
-                        for (int dx = -1; dx <= 1; ++dx)
-                        {
-                            const BlockInfo b = utils::getBlock(x + dx, y + dy, z + dz, chunk,
-                                neighbours);
-                            const BlockDescription &d = registry->getBlock(b.id);
-                            descs.setBlockAtOffset(dx, dy, dz, &d);
-                        }
+                        const BlockInfo b = padded_blocks_[padded_index + neighbour_offsets[i]];
+                        descs.blocks[i] = &registry.getBlock(b.id);
                     }
-                }
 
-                if (is_air(1, 0, 0, descs))
-                {
-                    gen_face_px(min, max, descs, mesh);
-                }
-                if (is_air(-1, 0, 0, descs))
-                {
-                    gen_face_nx(min, max, descs, mesh);
+                    if (is_air(1, 0, 0, descs))
+                    {
+                        gen_face_px(min, max, descs, vertices);
+                    }
+                    if (is_air(-1, 0, 0, descs))
+                    {
+                        gen_face_nx(min, max, descs, vertices);
+                    }
+                    if (is_air(0, 1, 0, descs))
+                    {
+                        gen_face_py(min, max, descs, vertices);
+                    }
+                    if (y != 0 && is_air(0, -1, 0, descs)) // don't spam -y faces for 0 blocks
+                    {
+                        gen_face_ny(min, max, descs, vertices);
+                    }
+                    if (is_air(0, 0, 1, descs))
+                    {
+                        gen_face_pz(min, max, descs, vertices);
+                    }
+                    if (is_air(0, 0, -1, descs))
+                    {
+                        gen_face_nz(min, max, descs, vertices);
+                    }
                 }
-                if (is_air(0, 1, 0, descs))
+            }
+        }
+    }
+}
+
+void ChunkMeshGenerator::fill_padded_blocks(const ChunkMeshSnapshot &snapshot)
+{
+    SCOPED_FUNC_PROFILER;
+
+    constexpr int W = Chunk::CHUNK_WIDTH;
+    constexpr int H = Chunk::CHUNK_HEIGHT;
+
+    // Nothing above and below the chunk
+    std::fill(padded_blocks_.begin(), padded_blocks_.begin() + PADDED_WIDTH2, BlockInfo{0});
+    std::fill(padded_blocks_.end() - PADDED_WIDTH2, padded_blocks_.end(), BlockInfo{0});
+
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        const ChunkSection &section = snapshot.getSection(section_index);
+        const int y_begin = section_index * Chunk::SECTION_HEIGHT;
+        const int y_end = y_begin + Chunk::SECTION_HEIGHT;
+
+        if (section.isUniform())
+        {
+            const BlockInfo block = section.getUniformBlock();
+            for (int y = y_begin; y < y_end; ++y)
+            {
+                for (int z = 0; z < W; ++z)
                 {
-                    gen_face_py(min, max, descs, mesh);
+                    std::fill_n(&padded_blocks_[get_padded_index(0, y, z)], W, block);
                 }
-                if (y != 0 && is_air(0, -1, 0, descs)) // don't spam -y faces for 0 blocks
+            }
+            continue;
+        }
+
+        section.getBlocks(section_blocks_.data());
+        int block_index = 0;
+        for (int y = y_begin; y < y_end; ++y)
+        {
+            for (int z = 0; z < W; ++z)
+            {
+                memcpy(&padded_blocks_[get_padded_index(0, y, z)], &section_blocks_[block_index],
+                    W * sizeof(BlockInfo));
+                block_index += W;
+            }
+        }
+    }
+
+    for (int y = 0; y < H; ++y)
+    {
+        for (int i = 0; i < W; ++i)
+        {
+            padded_blocks_[get_padded_index(-1, y, i)] = snapshot.nx[y][i];
+            padded_blocks_[get_padded_index(W, y, i)] = snapshot.px[y][i];
+            padded_blocks_[get_padded_index(i, y, -1)] = snapshot.nz[y][i];
+            padded_blocks_[get_padded_index(i, y, W)] = snapshot.pz[y][i];
+        }
+        padded_blocks_[get_padded_index(-1, y, -1)] = snapshot.nx_nz[y];
+        padded_blocks_[get_padded_index(W, y, -1)] = snapshot.px_nz[y];
+        padded_blocks_[get_padded_index(-1, y, W)] = snapshot.nx_pz[y];
+        padded_blocks_[get_padded_index(W, y, W)] = snapshot.px_pz[y];
+    }
+}
+
+// Texture coordinates inside a tile of the atlas
+constexpr glm::ivec2 UV_BOTTOM_LEFT{0, 0};
+constexpr glm::ivec2 UV_BOTTOM_RIGHT{1, 0};
+constexpr glm::ivec2 UV_TOP_LEFT{0, 1};
+constexpr glm::ivec2 UV_TOP_RIGHT{1, 1};
+
+namespace
+{
+
+struct FaceDescription
+{
+    glm::ivec3 normal;
+    int u_axis; // world axis along the texture u coordinate
+    int v_axis; // world axis along the texture v coordinate
+    // Corners of the face as offsets from the block center, same order as in gen_face_*
+    glm::ivec3 corners[4];
+    glm::ivec2 uvs[4];
+    int indices[6];
+};
+
+// clang-format off
+// Indexed by ChunkMeshData::Face
+constexpr FaceDescription FACES[6] = {
+    // px
+    {{1, 0, 0}, 2, 1,
+        {{+1, +1, +1}, {+1, -1, +1}, {+1, -1, -1}, {+1, +1, -1}},
+        {UV_TOP_LEFT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_RIGHT},
+        {0, 1, 2, 0, 2, 3}},
+    // nx
+    {{-1, 0, 0}, 2, 1,
+        {{-1, +1, +1}, {-1, -1, -1}, {-1, -1, +1}, {-1, +1, -1}},
+        {UV_TOP_RIGHT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_LEFT},
+        {0, 1, 2, 0, 3, 1}},
+    // py
+    {{0, 1, 0}, 0, 2,
+        {{-1, +1, -1}, {-1, +1, +1}, {+1, +1, +1}, {+1, +1, -1}},
+        {UV_TOP_LEFT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_RIGHT},
+        {0, 1, 2, 0, 2, 3}},
+    // ny
+    {{0, -1, 0}, 0, 2,
+        {{-1, -1, -1}, {+1, -1, +1}, {-1, -1, +1}, {+1, -1, -1}},
+        {UV_TOP_RIGHT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_LEFT},
+        {0, 1, 2, 0, 3, 1}},
+    // pz
+    {{0, 0, 1}, 0, 1,
+        {{-1, +1, +1}, {-1, -1, +1}, {+1, -1, +1}, {+1, +1, +1}},
+        {UV_TOP_LEFT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_RIGHT},
+        {0, 1, 2, 0, 2, 3}},
+    // nz
+    {{0, 0, -1}, 0, 1,
+        {{-1, +1, -1}, {+1, -1, -1}, {-1, -1, -1}, {+1, +1, -1}},
+        {UV_TOP_RIGHT, UV_BOTTOM_LEFT, UV_BOTTOM_RIGHT, UV_TOP_LEFT},
+        {0, 1, 2, 0, 3, 1}},
+};
+// clang-format on
+
+REALENGINE_INLINE constexpr int get_padded_offset(const glm::ivec3 &offset)
+{
+    return offset.x + PADDED_WIDTH * offset.z + PADDED_WIDTH2 * offset.y;
+}
+
+REALENGINE_INLINE glm::ivec3 get_axis_dir(int axis)
+{
+    glm::ivec3 dir{0, 0, 0};
+    dir[axis] = 1;
+    return dir;
+}
+
+// Face key: block id in the high bits, number of solid blocks around each corner (0-3) in the
+// low 8 bits. 0 - no face
+constexpr int FACE_KEY_AO_BITS = 8;
+constexpr uint32_t FACE_KEY_AO_MASK = (1u << FACE_KEY_AO_BITS) - 1;
+
+REALENGINE_INLINE int get_face_key_block(uint32_t key)
+{
+    return (int)(key >> FACE_KEY_AO_BITS);
+}
+
+REALENGINE_INLINE int get_face_key_ao(uint32_t key, int corner)
+{
+    return (int)((key >> (corner * 2)) & 3u);
+}
+
+// Faces with different ambient occlusion at the corners can't be merged, the interpolation would
+// stretch over the whole quad
+REALENGINE_INLINE bool is_face_key_mergeable(uint32_t key)
+{
+    const uint32_t ao = key & FACE_KEY_AO_MASK;
+    return ao == (ao & 3u) * 0x55u;
+}
+
+} // namespace
+
+void ChunkMeshGenerator::gen_greedy(const ChunkMeshSnapshot &snapshot,
+    std::vector<ChunkMeshData::Vertex> &vertices)
+{
+    SCOPED_FUNC_PROFILER;
+
+    const BlocksRegistry &registry = snapshot.getRegistry();
+
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        if (can_skip_section(snapshot, section_index, registry))
+        {
+            continue;
+        }
+        for (int face_index = 0; face_index < 6; ++face_index)
+        {
+            gen_greedy_section_faces(section_index, face_index, registry, vertices);
+        }
+    }
+}
+
+void ChunkMeshGenerator::gen_greedy_section_faces(int section_index, int face_index,
+    const BlocksRegistry &registry, std::vector<ChunkMeshData::Vertex> &vertices)
+{
+    const FaceDescription &face = FACES[face_index];
+    constexpr int W = Chunk::CHUNK_WIDTH;
+    static_assert(W == Chunk::SECTION_HEIGHT);
+
+    const int u_axis = face.u_axis;
+    const int v_axis = face.v_axis;
+    const int n_axis = 3 - u_axis - v_axis;
+    const glm::ivec3 u_dir = get_axis_dir(u_axis);
+    const glm::ivec3 v_dir = get_axis_dir(v_axis);
+    const glm::ivec3 section_begin{0, section_index * Chunk::SECTION_HEIGHT, 0};
+
+    const auto is_solid_at = [&](int padded_index) {
+        return registry.getBlock(padded_blocks_[padded_index].id).type != BlockType::AIR;
+    };
+
+    const int normal_offset = get_padded_offset(face.normal);
+    int corner_offsets[4][3];
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::ivec3 u_off = u_dir * face.corners[i][u_axis];
+        const glm::ivec3 v_off = v_dir * face.corners[i][v_axis];
+        corner_offsets[i][0] = get_padded_offset(face.normal + u_off + v_off);
+        corner_offsets[i][1] = get_padded_offset(face.normal + u_off);
+        corner_offsets[i][2] = get_padded_offset(face.normal + v_off);
+    }
+
+    const auto get_face_key = [&](const glm::ivec3 &pos) -> uint32_t {
+        // don't spam -y faces for 0 blocks
+        if (face.normal.y < 0 && pos.y == 0)
+        {
+            return 0;
+        }
+        const int padded_index = get_padded_index(pos.x, pos.y, pos.z);
+        const int id = padded_blocks_[padded_index].id;
+        if (id == 0 || is_solid_at(padded_index + normal_offset))
+        {
+            return 0;
+        }
+        uint32_t key = (uint32_t)id << FACE_KEY_AO_BITS;
+        for (int i = 0; i < 4; ++i)
+        {
+            const uint32_t num_solid = (uint32_t)is_solid_at(padded_index + corner_offsets[i][0])
+                + (uint32_t)is_solid_at(padded_index + corner_offsets[i][1])
+                + (uint32_t)is_solid_at(padded_index + corner_offsets[i][2]);
+            key |= num_solid << (i * 2);
+        }
+        return key;
+    };
+
+    uint32_t *mask = greedy_mask_.data();
+
+    for (int slice = 0; slice < W; ++slice)
+    {
+        for (int v = 0; v < W; ++v)
+        {
+            for (int u = 0; u < W; ++u)
+            {
+                glm::ivec3 pos = section_begin;
+                pos[n_axis] += slice;
+                pos[u_axis] += u;
+                pos[v_axis] += v;
+                mask[u + W * v] = get_face_key(pos);
+            }
+        }
+
+        for (int v = 0; v < W; ++v)
+        {
+            for (int u = 0; u < W;)
+            {
+                const uint32_t key = mask[u + W * v];
+                if (key == 0)
                 {
-                    gen_face_ny(min, max, descs, mesh);
+                    ++u;
+                    continue;
                 }
-                if (is_air(0, 0, 1, descs))
+
+                int size_u = 1;
+                int size_v = 1;
+                if (is_face_key_mergeable(key))
                 {
-                    gen_face_pz(min, max, descs, mesh);
+                    while (u + size_u < W && mask[u + size_u + W * v] == key)
+                    {
+                        ++size_u;
+                    }
+                    for (; v + size_v < W; ++size_v)
+                    {
+                        const uint32_t *row = &mask[u + W * (v + size_v)];
+                        if (!std::all_of(row, row + size_u, [&](uint32_t k) { return k == key; }))
+                        {
+                            break;
+                        }
+                    }
                 }
-                if (is_air(0, 0, -1, descs))
+
+                for (int dv = 0; dv < size_v; ++dv)
                 {
-                    gen_face_nz(min, max, descs, mesh);
+                    std::fill_n(&mask[u + W * (v + dv)], size_u, 0u);
                 }
+
+                glm::ivec3 pos = section_begin;
+                pos[n_axis] += slice;
+                pos[u_axis] += u;
+                pos[v_axis] += v;
+                const glm::ivec3 max = pos + u_dir * size_u + v_dir * size_v
+                    + face.normal * face.normal;
+
+                gen_greedy_quad(pos, max, glm::ivec2(size_u, size_v), face_index, key, registry,
+                    vertices);
+
+                u += size_u;
             }
         }
     }
+}
+
+void ChunkMeshGenerator::gen_greedy_quad(const glm::ivec3 &min, const glm::ivec3 &max,
+    const glm::ivec2 &size, int face_index, uint32_t key, const BlocksRegistry &registry,
+    std::vector<ChunkMeshData::Vertex> &vertices)
+{
+    const FaceDescription &face = FACES[face_index];
+    const int tile = registry.getBlock(get_face_key_block(key)).texture_indexes[face_index];
+
+    ChunkMeshData::Vertex corners[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::ivec3 &corner = face.corners[i];
+        const glm::ivec3 pos{corner.x < 0 ? min.x : max.x, corner.y < 0 ? min.y : max.y,
+            corner.z < 0 ? min.z : max.z};
+        corners[i] = ChunkMeshData::packVertex(pos, face_index, face.uvs[i] * size, tile,
+            get_face_key_ao(key, i));
+    }
 
+    ChunkMeshData::Vertex vs[6];
+    for (int i = 0; i < 6; ++i)
     {
-        SCOPED_PROFILER("flush vbo");
-        mesh.flush();
+        vs[i] = corners[face.indices[i]];
     }
-    mesh.deallocate();
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-constexpr float FAR0 = 1.0f;
-constexpr float TOTAL = FAR0 * 3;
-constexpr float TOTAL_INV = 1.0f / TOTAL;
-
-void ChunkMeshGenerator::gen_face_py(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_py(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_py;
+    const int tile = descs.getCenter()->texture_index_py;
 
-    ChunkMesh::Vertex vs[6];
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{0, 1, 0};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, off_y, 0, descs) * FAR0 +
-                (float)is_solid(0, off_y, off_z, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, off_y, 0, descs) + (int)is_solid(0, off_y, off_z, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_PY, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(-1, +1, -1, coords.top_left);
-    vs[1] = gen_vertex(-1, +1, +1, coords.bottom_left);
-    vs[2] = gen_vertex(+1, +1, +1, coords.bottom_right);
+    vs[0] = gen_vertex(-1, +1, -1, UV_TOP_LEFT);
+    vs[1] = gen_vertex(-1, +1, +1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(+1, +1, +1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
     vs[4] = vs[2];
-    vs[5] = gen_vertex(+1, +1, -1, coords.top_right);
+    vs[5] = gen_vertex(+1, +1, -1, UV_TOP_RIGHT);
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-void ChunkMeshGenerator::gen_face_ny(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_ny(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_ny;
-    ChunkMesh::Vertex vs[6];
+    const int tile = descs.getCenter()->texture_index_ny;
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{0, -1, 0};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, off_y, 0, descs) * FAR0 +
-                (float)is_solid(0, off_y, off_z, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, off_y, 0, descs) + (int)is_solid(0, off_y, off_z, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_NY, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(-1, -1, -1, coords.top_right);
-    vs[1] = gen_vertex(+1, -1, +1, coords.bottom_left);
-    vs[2] = gen_vertex(-1, -1, +1, coords.bottom_right);
+    vs[0] = gen_vertex(-1, -1, -1, UV_TOP_RIGHT);
+    vs[1] = gen_vertex(+1, -1, +1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(-1, -1, +1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
-    vs[4] = gen_vertex(+1, -1, -1, coords.top_left);
+    vs[4] = gen_vertex(+1, -1, -1, UV_TOP_LEFT);
     vs[5] = vs[1];
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-void ChunkMeshGenerator::gen_face_pz(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_pz(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_pz;
-    ChunkMesh::Vertex vs[6];
+    const int tile = descs.getCenter()->texture_index_pz;
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{0, 0, 1};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, 0, off_z, descs) * FAR0 +
-                (float)is_solid(0, off_y, off_z, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, 0, off_z, descs) + (int)is_solid(0, off_y, off_z, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_PZ, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(-1, +1, +1, coords.top_left);
-    vs[1] = gen_vertex(-1, -1, +1, coords.bottom_left);
-    vs[2] = gen_vertex(+1, -1, +1, coords.bottom_right);
+    vs[0] = gen_vertex(-1, +1, +1, UV_TOP_LEFT);
+    vs[1] = gen_vertex(-1, -1, +1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(+1, -1, +1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
     vs[4] = vs[2];
-    vs[5] = gen_vertex(+1, +1, +1, coords.top_right);
+    vs[5] = gen_vertex(+1, +1, +1, UV_TOP_RIGHT);
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-void ChunkMeshGenerator::gen_face_nz(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_nz(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_nz;
-    ChunkMesh::Vertex vs[6];
+    const int tile = descs.getCenter()->texture_index_nz;
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{0, 0, -1};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, 0, off_z, descs) * FAR0 +
-                (float)is_solid(0, off_y, off_z, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, 0, off_z, descs) + (int)is_solid(0, off_y, off_z, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_NZ, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(-1, +1, -1, coords.top_right);
-    vs[1] = gen_vertex(+1, -1, -1, coords.bottom_left);
-    vs[2] = gen_vertex(-1, -1, -1, coords.bottom_right);
+    vs[0] = gen_vertex(-1, +1, -1, UV_TOP_RIGHT);
+    vs[1] = gen_vertex(+1, -1, -1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(-1, -1, -1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
-    vs[4] = gen_vertex(+1, +1, -1, coords.top_left);
+    vs[4] = gen_vertex(+1, +1, -1, UV_TOP_LEFT);
     vs[5] = vs[1];
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-void ChunkMeshGenerator::gen_face_px(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_px(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_px;
-    ChunkMesh::Vertex vs[6];
+    const int tile = descs.getCenter()->texture_index_px;
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{1, 0, 0};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, 0, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, off_y, 0, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, 0, off_z, descs) + (int)is_solid(off_x, off_y, 0, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_PX, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(+1, +1, +1, coords.top_left);
-    vs[1] = gen_vertex(+1, -1, +1, coords.bottom_left);
-    vs[2] = gen_vertex(+1, -1, -1, coords.bottom_right);
+    vs[0] = gen_vertex(+1, +1, +1, UV_TOP_LEFT);
+    vs[1] = gen_vertex(+1, -1, +1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(+1, -1, -1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
     vs[4] = vs[2];
-    vs[5] = gen_vertex(+1, +1, -1, coords.top_right);
+    vs[5] = gen_vertex(+1, +1, -1, UV_TOP_RIGHT);
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
 
-void ChunkMeshGenerator::gen_face_nx(const glm::vec3 &min, const glm::vec3 &max,
-    const Descriptions3x3 &descs, ChunkMesh &mesh)
+void ChunkMeshGenerator::gen_face_nx(const glm::ivec3 &min, const glm::ivec3 &max,
+    const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices)
 {
-    const BlockDescription::TexCoords &coords = descs.getCenter()->cached.texture_coord_nx;
-    ChunkMesh::Vertex vs[6];
+    const int tile = descs.getCenter()->texture_index_nx;
+    ChunkMeshData::Vertex vs[6];
 
-    constexpr glm::ivec3 ioffset{-1, 0, 0};
-    constexpr glm::vec3 offset{ioffset};
 
-    const glm::vec3 minmax[2] = {min, max};
+    const glm::ivec3 minmax[2] = {min, max};
     const auto get_min_max = [&](int off) {
         // off = -1 or 1
         return minmax[(off + 1) / 2];
     };
 
-    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::vec2 uv) {
-        ChunkMesh::Vertex v;
-        v.pos = glm::vec3{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
-        v.norm = offset;
-        v.uv = uv;
-        // clang-format off
-        v.ao = 1.0f
-            - (
-                (float)is_solid(off_x, off_y, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, 0, off_z, descs) * FAR0 +
-                (float)is_solid(off_x, off_y, 0, descs) * FAR0
-                )
-                * TOTAL_INV;
-        // clang-format on
-        return v;
+    const auto gen_vertex = [&](int off_x, int off_y, int off_z, glm::ivec2 uv) {
+        const glm::ivec3 pos{get_min_max(off_x).x, get_min_max(off_y).y, get_min_max(off_z).z};
+        const int ao = (int)is_solid(off_x, off_y, off_z, descs)
+            + (int)is_solid(off_x, 0, off_z, descs) + (int)is_solid(off_x, off_y, 0, descs);
+        return ChunkMeshData::packVertex(pos, ChunkMeshData::FACE_NX, uv, tile, ao);
     };
 
     // tr 1
-    vs[0] = gen_vertex(-1, +1, +1, coords.top_right);
-    vs[1] = gen_vertex(-1, -1, -1, coords.bottom_left);
-    vs[2] = gen_vertex(-1, -1, +1, coords.bottom_right);
+    vs[0] = gen_vertex(-1, +1, +1, UV_TOP_RIGHT);
+    vs[1] = gen_vertex(-1, -1, -1, UV_BOTTOM_LEFT);
+    vs[2] = gen_vertex(-1, -1, +1, UV_BOTTOM_RIGHT);
     // tr 2
     vs[3] = vs[0];
-    vs[4] = gen_vertex(-1, +1, -1, coords.top_left);
+    vs[4] = gen_vertex(-1, +1, -1, UV_TOP_LEFT);
     vs[5] = vs[1];
 
-    mesh.addRaw(vs, sizeof(ChunkMesh::Vertex) * 6);
+    vertices.insert(vertices.end(), vs, vs + 6);
 }
@@ -1,29 +1,69 @@
 #pragma once
 
-#include <glm/vec3.hpp>
+#include "Base.h"
+#include "BlockInfo.h"
+#include "ChunkMeshData.h"
 #include "Common.h"
 
-struct ExtendedNeighbourChunks;
-struct Chunk;
-struct ChunkMesh;
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <vector>
+
+struct ChunkMeshSnapshot;
+class BlocksRegistry;
 
+// Not thread safe, but doesn't touch the chunks, so a generator per thread can be used
 class ChunkMeshGenerator
 {
 public:
-    void rebuildMesh(const Chunk &chunk, ChunkMesh &mesh,
-        const ExtendedNeighbourChunks &neighbours);
+    enum class Mode
+    {
+        Naive,  // two triangles for each visible block face
+        Greedy, // coplanar faces with the same block and ambient occlusion are merged
+    };
+
+public:
+    ChunkMeshGenerator();
+
+    void setMode(Mode mode) { mode_ = mode; }
+    Mode getMode() const { return mode_; }
+
+    // The mesh is cleared first, its capacity is reused
+    void buildMesh(const ChunkMeshSnapshot &snapshot, ChunkMeshData &out_mesh);
 
 private:
-    static void gen_face_py(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
-    static void gen_face_ny(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
-    static void gen_face_pz(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
-    static void gen_face_nz(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
-    static void gen_face_px(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
-    static void gen_face_nx(const glm::vec3 &min, const glm::vec3 &max,
-        const Descriptions3x3 &descs, ChunkMesh &mesh);
+    // Copy the chunk blocks and the border blocks of the neighbours to the flat padded array, so
+    // the generation doesn't have to decode the paletted storage for every neighbour lookup
+    void fill_padded_blocks(const ChunkMeshSnapshot &snapshot);
+
+    void gen_naive(const ChunkMeshSnapshot &snapshot, std::vector<ChunkMeshData::Vertex> &vertices);
+
+    void gen_greedy(const ChunkMeshSnapshot &snapshot,
+        std::vector<ChunkMeshData::Vertex> &vertices);
+    void gen_greedy_section_faces(int section_index, int face_index,
+        const BlocksRegistry &registry, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_greedy_quad(const glm::ivec3 &min, const glm::ivec3 &max,
+        const glm::ivec2 &size, int face_index, uint32_t key, const BlocksRegistry &registry,
+        std::vector<ChunkMeshData::Vertex> &vertices);
+
+    static void gen_face_py(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_face_ny(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_face_pz(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_face_nz(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_face_px(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+    static void gen_face_nx(const glm::ivec3 &min, const glm::ivec3 &max,
+        const Descriptions3x3 &descs, std::vector<ChunkMeshData::Vertex> &vertices);
+
+private:
+    Mode mode_{Mode::Greedy};
+
+    std::vector<BlockInfo> section_blocks_;
+    std::vector<BlockInfo> padded_blocks_;
+    std::vector<uint32_t> greedy_mask_; // face keys of one slice of a section
 };
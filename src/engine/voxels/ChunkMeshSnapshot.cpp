@@ -0,0 +1,95 @@
+#include "ChunkMeshSnapshot.h"
+
+#include "BlockDescription.h"
+#include "BlocksRegistry.h"
+#include "Common.h"
+#include "profiler/ScopedProfiler.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr int W = ChunkMeshSnapshot::W;
+constexpr int SECTION_HEIGHT = Chunk::SECTION_HEIGHT;
+
+// Copy the blocks of the chunk plane at x = fixed_x or z = fixed_z (the other one is -1)
+void copy_plane(const Chunk &chunk, int fixed_x, int fixed_z, BlockInfo (*out)[W])
+{
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        const ChunkSection &section = chunk.getSection(section_index);
+        BlockInfo(*section_out)[W] = out + section_index * SECTION_HEIGHT;
+
+        if (section.isUniform())
+        {
+            std::fill_n(&section_out[0][0], SECTION_HEIGHT * W, section.getUniformBlock());
+            continue;
+        }
+
+        for (int y = 0; y < SECTION_HEIGHT; ++y)
+        {
+            for (int i = 0; i < W; ++i)
+            {
+                const int x = fixed_x == -1 ? i : fixed_x;
+                const int z = fixed_z == -1 ? i : fixed_z;
+                section_out[y][i] = section.getBlock(x + W * z + W * W * y);
+            }
+        }
+    }
+}
+
+void copy_column(const Chunk &chunk, int x, int z, BlockInfo *out)
+{
+    for (int section_index = 0; section_index < Chunk::NUM_SECTIONS; ++section_index)
+    {
+        const ChunkSection &section = chunk.getSection(section_index);
+        BlockInfo *section_out = out + section_index * SECTION_HEIGHT;
+
+        if (section.isUniform())
+        {
+            std::fill_n(section_out, SECTION_HEIGHT, section.getUniformBlock());
+            continue;
+        }
+
+        for (int y = 0; y < SECTION_HEIGHT; ++y)
+        {
+            section_out[y] = section.getBlock(x + W * z + W * W * y);
+        }
+    }
+}
+
+} // namespace
+
+void ChunkMeshSnapshot::init(const Chunk &chunk, const ExtendedNeighbourChunks &neighbours,
+    const BlocksRegistry &registry)
+{
+    assert(neighbours.hasAll());
+
+    SCOPED_FUNC_PROFILER;
+
+    position_ = chunk.getPosition();
+    registry_ = &registry;
+
+    solid_neighbour_sections_ = 0;
+    for (int i = 0; i < Chunk::NUM_SECTIONS; ++i)
+    {
+        sections_[i].copyFrom(chunk.getSection(i));
+
+        const bool solid = registry.isSolidSection(neighbours.px->getSection(i))
+            && registry.isSolidSection(neighbours.nx->getSection(i))
+            && registry.isSolidSection(neighbours.pz->getSection(i))
+            && registry.isSolidSection(neighbours.nz->getSection(i));
+        solid_neighbour_sections_ |= (uint32_t)solid << i;
+    }
+
+    copy_plane(*neighbours.nx, W - 1, -1, nx);
+    copy_plane(*neighbours.px, 0, -1, px);
+    copy_plane(*neighbours.nz, -1, W - 1, nz);
+    copy_plane(*neighbours.pz, -1, 0, pz);
+
+    copy_column(*neighbours.nx_nz, W - 1, W - 1, nx_nz);
+    copy_column(*neighbours.px_nz, 0, W - 1, px_nz);
+    copy_column(*neighbours.nx_pz, W - 1, 0, nx_pz);
+    copy_column(*neighbours.px_pz, 0, 0, px_pz);
+}
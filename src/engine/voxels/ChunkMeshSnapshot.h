@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Base.h"
+#include "BlockInfo.h"
+#include "Chunk.h"
+#include "ChunkSection.h"
+
+#include <glm/vec3.hpp>
+#include <cstdint>
+
+struct ExtendedNeighbourChunks;
+class BlocksRegistry;
+
+// Copy of the chunk blocks and the neighbour blocks touching the chunk. The mesh is built from the
+// snapshot in a worker thread while the chunks can be modified in the main thread.
+struct ChunkMeshSnapshot
+{
+public:
+    static constexpr int W = Chunk::CHUNK_WIDTH;
+    static constexpr int H = Chunk::CHUNK_HEIGHT;
+
+    ChunkMeshSnapshot() = default;
+
+    REMOVE_COPY_MOVE_CLASS(ChunkMeshSnapshot);
+
+    void init(const Chunk &chunk, const ExtendedNeighbourChunks &neighbours,
+        const BlocksRegistry &registry);
+
+    const glm::ivec3 &getPosition() const { return position_; }
+    // The registry passed to init(), the block descriptions are read by the mesh generator
+    const BlocksRegistry &getRegistry() const
+    {
+        assert(registry_);
+        return *registry_;
+    }
+
+    const ChunkSection &getSection(int index) const
+    {
+        assert(index >= 0 && index < Chunk::NUM_SECTIONS);
+        return sections_[index];
+    }
+
+    // Whether all the 4 side neighbours have a section with the index filled with a solid block
+    bool isNeighbourSectionsSolid(int index) const
+    {
+        return (solid_neighbour_sections_ >> index) & 1u;
+    }
+
+public:
+    // Neighbour blocks touching the chunk sides, [y][x or z]
+    BlockInfo nx[H][W];
+    BlockInfo px[H][W];
+    BlockInfo nz[H][W];
+    BlockInfo pz[H][W];
+
+    // Neighbour blocks touching the chunk corners, [y]
+    BlockInfo nx_nz[H];
+    BlockInfo px_nz[H];
+    BlockInfo nx_pz[H];
+    BlockInfo px_pz[H];
+
+private:
+    glm::ivec3 position_{};
+    const BlocksRegistry *registry_{};
+    ChunkSection sections_[Chunk::NUM_SECTIONS];
+    uint32_t solid_neighbour_sections_{0};
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Base.h"
+#include "BlockInfo.h"
+#include "PalettedBlocks.h"
+
+// 16x16x16 part of a chunk. Blocks order in memory: XZY
+struct ChunkSection
+{
+public:
+    static constexpr int WIDTH = 16;
+    static constexpr int HEIGHT = 16;
+    static constexpr int NUM_BLOCKS = WIDTH * WIDTH * HEIGHT;
+
+    enum class State
+    {
+        Empty,   // all blocks are air
+        Uniform, // all blocks are the same non-air block
+        Mixed,
+    };
+
+public:
+    ChunkSection() = default;
+
+    REMOVE_COPY_MOVE_CLASS(ChunkSection);
+
+    REALENGINE_INLINE State getState() const
+    {
+        if (!blocks_.isUniform())
+        {
+            return State::Mixed;
+        }
+        return blocks_.getUniformBlock().id == 0 ? State::Empty : State::Uniform;
+    }
+
+    REALENGINE_INLINE bool isEmpty() const { return getState() == State::Empty; }
+    REALENGINE_INLINE bool isUniform() const { return blocks_.isUniform(); }
+    REALENGINE_INLINE BlockInfo getUniformBlock() const { return blocks_.getUniformBlock(); }
+
+    REALENGINE_INLINE BlockInfo getBlock(int index) const { return blocks_.get(index); }
+
+    REALENGINE_INLINE void setBlock(int index, BlockInfo block) { blocks_.set(index, block); }
+
+    void fill(BlockInfo block) { blocks_.fill(block); }
+
+    void copyFrom(const ChunkSection &other) { blocks_.copyFrom(other.blocks_); }
+
+    // Decode all blocks to the flat array of NUM_BLOCKS elements
+    void getBlocks(BlockInfo *out_blocks) const { blocks_.getAll(out_blocks); }
+    void setBlocks(const BlockInfo *blocks) { blocks_.setAll(blocks); }
+
+    uint64_t getMemoryUsage() const
+    {
+        return sizeof(ChunkSection) - sizeof(PalettedBlocks) + blocks_.getMemoryUsage();
+    }
+
+private:
+    PalettedBlocks blocks_{NUM_BLOCKS};
+};
@@ -1,6 +1,9 @@
 #include "ChunksMap.h"
 
 #include "math/Math.h"
+#include "utils/Algos.h"
+
+#include <cstdlib>
 
 namespace
 {
@@ -22,35 +25,13 @@ REALENGINE_INLINE bool is_valid_pos(int radius, glm::ivec2 loc_pos)
         && loc_pos.y <= radius;
 }
 
-REALENGINE_INLINE int get_index(int radius, glm::ivec2 loc_pos)
-{
-    assert(is_valid_pos(radius, loc_pos));
-    return (loc_pos.x + radius) + (loc_pos.y + radius) * (radius * 2 + 1);
-}
-
-REALENGINE_INLINE UPtr<Chunk> &get_chunk_by_loc_pos(std::vector<UPtr<Chunk>> &chunks, int radius,
-    glm::ivec2 loc_pos)
-{
-    assert(chunks.size() == arr_length_from_radius(radius));
-    const int index = get_index(radius, loc_pos);
-    return chunks[index];
-}
-
-REALENGINE_INLINE const UPtr<Chunk> &get_chunk_by_loc_pos(const std::vector<UPtr<Chunk>> &chunks,
-    int radius, glm::ivec2 loc_pos)
-{
-    assert(chunks.size() == arr_length_from_radius(radius));
-    const int index = get_index(radius, loc_pos);
-    return chunks[index];
-}
-
 } // namespace
 
 ChunksMap::ChunksMap()
 {
-    const int len = arr_length_from_radius(radius_);
-    chunks_.resize(len);
-    chunks_old_.resize(len);
+    width_ = arr_width_from_radius(radius_);
+    chunks_.resize(arr_length_from_radius(radius_));
+    states_.resize(arr_length_from_radius(radius_));
 }
 
 void ChunksMap::setRadius(int radius)
@@ -61,50 +42,48 @@ void ChunksMap::setRadius(int radius)
     }
 
     assert(check_sizes());
+    // States of the positions outside of the radius can't be placed again
+    assert(Alg::allOf(states_, [](const SlotState &s) {
+        return !s.meshing && (s.state == ChunkState::None || s.state == ChunkState::Loaded);
+    }));
 
-    const bool expand = radius > radius_;
-    const bool collapse = !expand;
-    const int min_radius = expand ? radius_ : radius;
+    const bool collapse = radius < radius_;
 
-    assert(check_buf_empty());
-    std::swap(chunks_, chunks_old_);
+    std::vector<UPtr<Chunk>> old_chunks;
+    std::swap(old_chunks, chunks_);
 
-    const int new_len = arr_length_from_radius(radius);
-    chunks_.resize(new_len);
+    radius_ = radius;
+    width_ = arr_width_from_radius(radius);
+    chunks_.resize(arr_length_from_radius(radius));
+    states_.assign(arr_length_from_radius(radius), SlotState{});
 
-    // TODO: walk by array coordinates
-    for (int loc_y = -min_radius; loc_y <= min_radius; ++loc_y)
+    // Slots depend on the width, so all the chunks have to be placed again
+    for (UPtr<Chunk> &old : old_chunks)
     {
-        for (int loc_x = -min_radius; loc_x <= min_radius; ++loc_x)
+        if (!old)
         {
-            if (collapse && math::isOutsideRadius(loc_x, loc_y, radius))
-            {
-                continue;
-            }
-
-            UPtr<Chunk> &old = get_chunk_by_loc_pos(chunks_old_, radius_, glm::ivec2{loc_x, loc_y});
-            UPtr<Chunk> &neww = get_chunk_by_loc_pos(chunks_, radius, glm::ivec2{loc_x, loc_y});
-            neww = std::move(old);
+            continue;
         }
-    }
-
-    if (collapse)
-    {
-        for (UPtr<Chunk> &old : chunks_old_)
+        const glm::ivec2 pos = old->getPositionXZ();
+        const glm::ivec2 loc_pos = pos - center_chunk_pos_;
+        if (!is_valid_pos(radius_, loc_pos)
+            || (collapse && math::isOutsideRadius(loc_pos.x, loc_pos.y, radius)))
         {
-            if (old && unload_callback_)
+            if (unload_callback_)
             {
                 unload_callback_(std::move(old));
             }
-            assert(!old);
+            continue;
         }
+        const int index = get_slot_index(pos);
+        chunks_[index] = std::move(old);
+        states_[index].pos = pos;
+        states_[index].state = ChunkState::Loaded;
     }
 
-    radius_ = radius;
-    chunks_old_.resize(new_len);
-
-    assert(check_buf_empty());
     assert(check_sizes());
+    assert(check_positions());
+    assert(check_states());
 }
 
 int ChunksMap::getRadius() const
@@ -121,48 +100,42 @@ void ChunksMap::setCenter(glm::ivec2 center)
 
     assert(check_sizes());
 
-    assert(check_buf_empty());
-    std::swap(chunks_, chunks_old_);
-
-    const glm::ivec2 delta = center - center_chunk_pos_;
-
-    const glm::ivec2 radius_vec{radius_, radius_};
-
-    glm::ivec2 old_top_right_in_new_coords = radius_vec - delta;
-    glm::ivec2 old_bottom_left_in_new_coords = -radius_vec - delta;
+    const glm::ivec2 old_center = center_chunk_pos_;
+    center_chunk_pos_ = center;
 
-    if (old_top_right_in_new_coords.x >= -radius_ && old_top_right_in_new_coords.y >= -radius_
-        && old_bottom_left_in_new_coords.x <= radius_ && old_bottom_left_in_new_coords.y <= radius_)
+    const glm::ivec2 delta = center - old_center;
+    if (std::abs(delta.x) >= width_ || std::abs(delta.y) >= width_)
     {
-        old_top_right_in_new_coords = glm::min(old_top_right_in_new_coords, radius_vec);
-        old_bottom_left_in_new_coords = glm::max(old_bottom_left_in_new_coords, -radius_vec);
-
-        for (int loc_y = old_bottom_left_in_new_coords.y; loc_y <= old_top_right_in_new_coords.y;
-             ++loc_y)
+        for (int i = 0, size = (int)chunks_.size(); i < size; ++i)
         {
-            for (int loc_x = old_bottom_left_in_new_coords.x;
-                 loc_x <= old_top_right_in_new_coords.x; ++loc_x)
-            {
-                const glm::ivec2 pos{loc_x, loc_y};
-                UPtr<Chunk> &old = get_chunk_by_loc_pos(chunks_old_, radius_, pos + delta);
-                UPtr<Chunk> &neww = get_chunk_by_loc_pos(chunks_, radius_, pos);
-                neww = std::move(old);
-            }
+            unload_slot(i);
         }
+        assert(check_states());
+        return;
     }
 
-    for (UPtr<Chunk> &old : chunks_old_)
+    // Columns which left the radius
+    if (delta.x > 0)
     {
-        if (old && unload_callback_)
-        {
-            unload_callback_(std::move(old));
-        }
-        assert(!old);
+        unload_outside(old_center, -radius_, -radius_ + delta.x - 1, -radius_, radius_);
+    }
+    else if (delta.x < 0)
+    {
+        unload_outside(old_center, radius_ + delta.x + 1, radius_, -radius_, radius_);
     }
 
-    assert(check_buf_empty());
+    // Rows which left the radius
+    if (delta.y > 0)
+    {
+        unload_outside(old_center, -radius_, radius_, -radius_, -radius_ + delta.y - 1);
+    }
+    else if (delta.y < 0)
+    {
+        unload_outside(old_center, -radius_, radius_, radius_ + delta.y + 1, radius_);
+    }
 
-    center_chunk_pos_ = center;
+    assert(check_positions());
+    assert(check_states());
 }
 
 glm::vec2 ChunksMap::getCenter() const
@@ -178,8 +151,9 @@ bool ChunksMap::isValidPos(glm::ivec2 pos) const
 
 Chunk *ChunksMap::getChunkUnsafe(glm::ivec2 pos) const
 {
-    const glm::ivec2 loc_pos = pos - center_chunk_pos_;
-    const UPtr<Chunk> &c = get_chunk_by_loc_pos(chunks_, radius_, loc_pos);
+    assert(isValidPos(pos));
+    const UPtr<Chunk> &c = chunks_[get_slot_index(pos)];
+    assert(!c || c->getPositionXZ() == pos);
     return c.get();
 }
 
@@ -190,30 +164,37 @@ bool ChunksMap::hasChunkUnsafe(glm::ivec2 pos) const
 
 void ChunksMap::setChunkUnsafe(glm::ivec2 pos, UPtr<Chunk> chunk)
 {
+    assert(isValidPos(pos));
     assert(!hasChunkUnsafe(pos));
-    const glm::ivec2 loc_pos = pos - center_chunk_pos_;
-    UPtr<Chunk> &c = get_chunk_by_loc_pos(chunks_, radius_, loc_pos);
+    assert(!isSlotBusy(pos));
+    const int index = get_slot_index(pos);
 
     chunk->setPosition(glm::ivec3{pos.x, 0, pos.y});
-    c = std::move(chunk);
+    chunks_[index] = std::move(chunk);
+    states_[index].pos = pos;
+    states_[index].state = ChunkState::Loaded;
 }
 
 UPtr<Chunk> ChunksMap::takeChunkUnsafe(glm::ivec2 pos)
 {
-    const glm::ivec2 loc_pos = pos - center_chunk_pos_;
-    UPtr<Chunk> &c = get_chunk_by_loc_pos(chunks_, radius_, loc_pos);
+    assert(isValidPos(pos));
+    const int index = get_slot_index(pos);
+    UPtr<Chunk> &c = chunks_[index];
+    assert(!c || c->getPositionXZ() == pos);
+    if (c)
+    {
+        states_[index].state = ChunkState::None;
+    }
     return std::move(c);
 }
 
 Chunk *ChunksMap::getChunk(glm::ivec2 pos) const
 {
-    const glm::ivec2 loc_pos = pos - center_chunk_pos_;
-    if (!is_valid_pos(radius_, loc_pos))
+    if (!isValidPos(pos))
     {
         return nullptr;
     }
-    const UPtr<Chunk> &c = get_chunk_by_loc_pos(chunks_, radius_, loc_pos);
-    return c.get();
+    return getChunkUnsafe(pos);
 }
 
 bool ChunksMap::hasChunk(glm::ivec2 pos) const
@@ -223,13 +204,29 @@ bool ChunksMap::hasChunk(glm::ivec2 pos) const
 
 UPtr<Chunk> ChunksMap::takeChunk(glm::ivec2 pos)
 {
-    const glm::ivec2 loc_pos = pos - center_chunk_pos_;
-    if (!is_valid_pos(radius_, loc_pos))
+    if (!isValidPos(pos))
     {
         return nullptr;
     }
-    UPtr<Chunk> &c = get_chunk_by_loc_pos(chunks_, radius_, loc_pos);
-    return std::move(c);
+    return takeChunkUnsafe(pos);
+}
+
+void ChunksMap::setChunkState(glm::ivec2 pos, ChunkState state)
+{
+    assert(state != ChunkState::Loaded);
+    assert(!isSlotBusy(pos));
+    SlotState &s = states_[get_slot_index(pos)];
+    assert(s.pos != pos || s.state != ChunkState::Loaded);
+    s.pos = pos;
+    s.state = state;
+}
+
+void ChunksMap::setMeshing(glm::ivec2 pos, bool meshing)
+{
+    assert(!isSlotBusy(pos));
+    SlotState &s = states_[get_slot_index(pos)];
+    s.pos = pos;
+    s.meshing = meshing;
 }
 
 void ChunksMap::setUnloadCallback(UnloadCallback callback)
@@ -242,17 +239,80 @@ void ChunksMap::clearUnloadCallback()
     unload_callback_ = nullptr;
 }
 
+void ChunksMap::unload_outside(glm::ivec2 old_center, int min_x, int max_x, int min_y, int max_y)
+{
+    for (int loc_y = min_y; loc_y <= max_y; ++loc_y)
+    {
+        for (int loc_x = min_x; loc_x <= max_x; ++loc_x)
+        {
+            const glm::ivec2 pos = old_center + glm::ivec2{loc_x, loc_y};
+            const int index = get_slot_index(pos);
+            const UPtr<Chunk> &chunk = chunks_[index];
+            if (chunk && !isValidPos(chunk->getPositionXZ()))
+            {
+                unload_slot(index);
+            }
+        }
+    }
+}
+
+void ChunksMap::unload_slot(int index)
+{
+    UPtr<Chunk> &chunk = chunks_[index];
+    if (!chunk)
+    {
+        return;
+    }
+    assert(states_[index].state == ChunkState::Loaded);
+    // Mesh job of the chunk (if any) still owns the slot until it's finished
+    states_[index].state = ChunkState::None;
+    if (unload_callback_)
+    {
+        unload_callback_(std::move(chunk));
+    }
+    chunk = nullptr;
+}
+
 bool ChunksMap::check_sizes() const
 {
-    const int len = arr_length_from_radius(radius_);
-    return chunks_.size() == len && chunks_old_.size() == len;
+    return width_ == arr_width_from_radius(radius_)
+        && (int)chunks_.size() == arr_length_from_radius(radius_)
+        && (int)states_.size() == arr_length_from_radius(radius_);
 }
 
-bool ChunksMap::check_buf_empty() const
+bool ChunksMap::check_positions() const
 {
-    for (const UPtr<Chunk> &b : chunks_old_)
+    for (int i = 0; i < (int)chunks_.size(); ++i)
     {
-        if (b)
+        const UPtr<Chunk> &chunk = chunks_[i];
+        if (!chunk)
+        {
+            continue;
+        }
+        const glm::ivec2 pos = chunk->getPositionXZ();
+        if (!isValidPos(pos) || get_slot_index(pos) != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChunksMap::check_states() const
+{
+    for (int i = 0; i < (int)chunks_.size(); ++i)
+    {
+        const UPtr<Chunk> &chunk = chunks_[i];
+        const SlotState &s = states_[i];
+        if ((s.state == ChunkState::Loaded) != (chunk != nullptr))
+        {
+            return false;
+        }
+        if (chunk && chunk->getPositionXZ() != s.pos)
+        {
+            return false;
+        }
+        if (!is_slot_free(s) && get_slot_index(s.pos) != i)
         {
             return false;
         }
@@ -4,15 +4,27 @@
 #include "Chunk.h"
 #include "signals/Signals.h"
 
+#include <cstdint>
 #include <functional>
 #include <vector>
 
 // XXX0XXX - radius=3!
+// Chunks are stored in a toroidal (wrap-around) grid: the slot of a chunk depends only on its
+// position modulo the grid width, so moving the center only unloads the rows/columns that left
+// the radius, the rest of the chunks stay in their slots.
 class ChunksMap
 {
 public:
     using UnloadCallback = std::function<void(UPtr<Chunk>)>;
 
+    enum class ChunkState : uint8_t
+    {
+        None,
+        Queued,    // generation job is enqueued or running
+        Generated, // generated, but not added to the map yet
+        Loaded,    // the chunk is in the map
+    };
+
 public:
     ChunksMap();
 
@@ -34,22 +46,74 @@ public:
     bool hasChunk(glm::ivec2 pos) const;
     UPtr<Chunk> takeChunk(glm::ivec2 pos);
 
+    // The states are stored in the slots too, so a slot is owned by a position while it has a
+    // chunk, a non-None state or a mesh job. The owner can be outside of the radius (e.g. a job
+    // which wasn't finished before the center moved)
+    REALENGINE_INLINE ChunkState getChunkState(glm::ivec2 pos) const
+    {
+        const SlotState &s = states_[get_slot_index(pos)];
+        return s.pos == pos ? s.state : ChunkState::None;
+    }
+    // Loaded state is managed by the map itself
+    void setChunkState(glm::ivec2 pos, ChunkState state);
+
+    REALENGINE_INLINE bool isMeshing(glm::ivec2 pos) const
+    {
+        const SlotState &s = states_[get_slot_index(pos)];
+        return s.pos == pos && s.meshing;
+    }
+    void setMeshing(glm::ivec2 pos, bool meshing);
+
+    // The slot of the position is owned by another position
+    REALENGINE_INLINE bool isSlotBusy(glm::ivec2 pos) const
+    {
+        const SlotState &s = states_[get_slot_index(pos)];
+        return s.pos != pos && !is_slot_free(s);
+    }
+
     void setUnloadCallback(UnloadCallback callback);
     void clearUnloadCallback();
 
     // TODO: it fucks incapsulation a bit
+    // NOTE: slots order doesn't depend on the center
     std::vector<UPtr<Chunk>> &getChunks() { return chunks_; }
     const std::vector<UPtr<Chunk>> &getChunks() const { return chunks_; }
 
 private:
+    struct SlotState
+    {
+        glm::ivec2 pos{};
+        ChunkState state{ChunkState::None};
+        bool meshing{false};
+    };
+
+    static REALENGINE_INLINE bool is_slot_free(const SlotState &s)
+    {
+        return s.state == ChunkState::None && !s.meshing;
+    }
+
+    REALENGINE_INLINE int get_slot_index(glm::ivec2 pos) const
+    {
+        int x = pos.x % width_;
+        int y = pos.y % width_;
+        x += x < 0 ? width_ : 0;
+        y += y < 0 ? width_ : 0;
+        return x + y * width_;
+    }
+
+    // Unload chunks in the old square around the center, which are outside the current one
+    void unload_outside(glm::ivec2 old_center, int min_x, int max_x, int min_y, int max_y);
+    void unload_slot(int index);
+
     bool check_sizes() const;
-    bool check_buf_empty() const;
+    bool check_positions() const;
+    bool check_states() const;
 
 private:
     int radius_{0};
+    int width_{1};
     glm::ivec2 center_chunk_pos_{};
-    glm::ivec2 center_chunk_in_vec_{};
     std::vector<UPtr<Chunk>> chunks_;
-    std::vector<UPtr<Chunk>> chunks_old_;
+    std::vector<SlotState> states_;
     UnloadCallback unload_callback_;
 };
@@ -0,0 +1,209 @@
+#include "PalettedBlocks.h"
+
+namespace
+{
+
+REALENGINE_INLINE int get_num_words(int size, int bits)
+{
+    return (size * bits + 63) / 64;
+}
+
+} // namespace
+
+PalettedBlocks::PalettedBlocks(int size)
+    : size_(size)
+{
+    assert(size > 0);
+    fill(BlockInfo{0});
+}
+
+void PalettedBlocks::fill(BlockInfo block)
+{
+    palette_.assign(1, block);
+    palette_.shrink_to_fit();
+    counts_.assign(1, size_);
+    counts_.shrink_to_fit();
+    bits_ = 0;
+    mask_ = 0;
+    data_.clear();
+    data_.shrink_to_fit();
+}
+
+void PalettedBlocks::copyFrom(const PalettedBlocks &other)
+{
+    assert(size_ == other.size_);
+    bits_ = other.bits_;
+    mask_ = other.mask_;
+    palette_ = other.palette_;
+    counts_ = other.counts_;
+    data_ = other.data_;
+}
+
+void PalettedBlocks::set(int index, BlockInfo block)
+{
+    assert(index >= 0 && index < size_);
+
+    const int old_palette_index = bits_ == 0 ? 0 : get_palette_index(index);
+    if (palette_[old_palette_index] == block)
+    {
+        return;
+    }
+
+    // Can widen the indices, but the old palette index stays valid
+    const int palette_index = find_or_add(block);
+    assert(bits_ > 0);
+
+    set_palette_index(index, palette_index);
+    --counts_[old_palette_index];
+    ++counts_[palette_index];
+
+    if (counts_[palette_index] == (uint32_t)size_)
+    {
+        fill(block);
+    }
+}
+
+void PalettedBlocks::getAll(BlockInfo *out_blocks) const
+{
+    if (bits_ == 0)
+    {
+        const BlockInfo block = palette_[0];
+        for (int i = 0; i < size_; ++i)
+        {
+            out_blocks[i] = block;
+        }
+        return;
+    }
+
+    const int per_word = 64 / bits_;
+    int index = 0;
+    for (uint64_t word : data_)
+    {
+        for (int i = 0; i < per_word && index < size_; ++i, ++index)
+        {
+            out_blocks[index] = palette_[word & mask_];
+            word >>= bits_;
+        }
+    }
+    assert(index == size_);
+}
+
+void PalettedBlocks::setAll(const BlockInfo *blocks)
+{
+    palette_.clear();
+    counts_.clear();
+
+    // Blocks mostly come in runs, so the last found entry is checked first
+    const auto find_index = [&](BlockInfo block, int last_index) {
+        if (last_index >= 0 && palette_[last_index] == block)
+        {
+            return last_index;
+        }
+        for (int i = 0, size = (int)palette_.size(); i < size; ++i)
+        {
+            if (palette_[i] == block)
+            {
+                return i;
+            }
+        }
+        return -1;
+    };
+
+    int last_index = -1;
+    for (int i = 0; i < size_; ++i)
+    {
+        int palette_index = find_index(blocks[i], last_index);
+        if (palette_index == -1)
+        {
+            palette_index = (int)palette_.size();
+            palette_.push_back(blocks[i]);
+            counts_.push_back(0);
+        }
+        ++counts_[palette_index];
+        last_index = palette_index;
+    }
+
+    if (palette_.size() == 1)
+    {
+        fill(palette_[0]);
+        return;
+    }
+
+    int bits = 1;
+    while ((1 << bits) < (int)palette_.size())
+    {
+        bits *= 2;
+    }
+    bits_ = bits;
+    mask_ = (uint64_t(1) << bits) - 1;
+    data_.assign(get_num_words(size_, bits), 0);
+
+    last_index = -1;
+    for (int i = 0; i < size_; ++i)
+    {
+        const int palette_index = find_index(blocks[i], last_index);
+        const uint32_t bit = (uint32_t)i * bits;
+        data_[bit >> 6] |= (uint64_t)palette_index << (bit & 63);
+        last_index = palette_index;
+    }
+}
+
+uint64_t PalettedBlocks::getMemoryUsage() const
+{
+    return sizeof(PalettedBlocks) + palette_.capacity() * sizeof(BlockInfo)
+        + counts_.capacity() * sizeof(uint32_t) + data_.capacity() * sizeof(uint64_t);
+}
+
+int PalettedBlocks::find_or_add(BlockInfo block)
+{
+    int free_index = -1;
+    for (int i = 0, size = (int)palette_.size(); i < size; ++i)
+    {
+        if (counts_[i] == 0)
+        {
+            if (free_index == -1)
+            {
+                free_index = i;
+            }
+            continue;
+        }
+        if (palette_[i] == block)
+        {
+            return i;
+        }
+    }
+
+    if (free_index != -1)
+    {
+        palette_[free_index] = block;
+        return free_index;
+    }
+
+    const int index = (int)palette_.size();
+    palette_.push_back(block);
+    counts_.push_back(0);
+
+    if (index >= (1 << bits_))
+    {
+        resize_bits(bits_ == 0 ? 1 : bits_ * 2);
+    }
+    return index;
+}
+
+void PalettedBlocks::resize_bits(int bits)
+{
+    assert(bits > bits_ && bits <= 32 && 64 % bits == 0);
+
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    std::vector<uint64_t> data(get_num_words(size_, bits), 0);
+    for (int i = 0; i < size_; ++i)
+    {
+        const uint64_t palette_index = bits_ == 0 ? 0 : get_palette_index(i);
+        const uint32_t bit = (uint32_t)i * bits;
+        data[bit >> 6] |= palette_index << (bit & 63);
+    }
+
+    data_ = std::move(data);
+    bits_ = bits;
+    mask_ = mask;
+}
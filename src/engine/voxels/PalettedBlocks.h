@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Base.h"
+#include "BlockInfo.h"
+
+#include <cstdint>
+#include <vector>
+
+// Stores blocks as indices into a palette of distinct ids. Indices are bit-packed into 64-bit
+// words and widened on demand (0, 1, 2, 4, 8, 16 bits per block). A storage filled with a single
+// block has 0 bits per block and doesn't allocate any index memory.
+class PalettedBlocks
+{
+public:
+    explicit PalettedBlocks(int size);
+
+    REMOVE_COPY_CLASS(PalettedBlocks);
+
+    void fill(BlockInfo block);
+
+    // Explicit copy, the storage memory is reused if possible
+    void copyFrom(const PalettedBlocks &other);
+
+    REALENGINE_INLINE BlockInfo get(int index) const
+    {
+        assert(index >= 0 && index < size_);
+        if (bits_ == 0)
+        {
+            return palette_[0];
+        }
+        return palette_[get_palette_index(index)];
+    }
+
+    void set(int index, BlockInfo block);
+
+    // Decode all blocks to the flat array (must have getSize() elements)
+    void getAll(BlockInfo *out_blocks) const;
+    // Replace all blocks, the palette is rebuilt with the minimal bits per block
+    void setAll(const BlockInfo *blocks);
+
+    int getSize() const { return size_; }
+    int getBitsPerBlock() const { return bits_; }
+    int getPaletteSize() const { return (int)palette_.size(); }
+
+    bool isUniform() const { return bits_ == 0; }
+    BlockInfo getUniformBlock() const
+    {
+        assert(isUniform());
+        return palette_[0];
+    }
+
+    uint64_t getMemoryUsage() const;
+
+private:
+    REALENGINE_INLINE int get_palette_index(int index) const
+    {
+        const uint32_t bit = (uint32_t)index * bits_;
+        return (int)((data_[bit >> 6] >> (bit & 63)) & mask_);
+    }
+
+    REALENGINE_INLINE void set_palette_index(int index, int palette_index)
+    {
+        const uint32_t bit = (uint32_t)index * bits_;
+        uint64_t &word = data_[bit >> 6];
+        const uint32_t shift = bit & 63;
+        word = (word & ~(mask_ << shift)) | ((uint64_t)palette_index << shift);
+    }
+
+    int find_or_add(BlockInfo block);
+    void resize_bits(int bits);
+
+private:
+    int size_{0};
+    int bits_{0};
+    uint64_t mask_{0};
+
+    std::vector<BlockInfo> palette_;
+    std::vector<uint32_t> counts_; // number of blocks per palette entry, 0 - free entry
+    std::vector<uint64_t> data_;
+};
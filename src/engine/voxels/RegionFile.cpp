@@ -0,0 +1,187 @@
+#include "RegionFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+
+constexpr uint32_t REGION_MAGIC = 0x4e475252; // "RRGN"
+constexpr uint32_t REGION_VERSION = 2;
+
+// Payloads are allocated in pages, so the edited chunks mostly fit in place
+constexpr uint32_t PAYLOAD_ALIGNMENT = 4096;
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+};
+
+} // namespace
+
+RegionFile::RegionFile(std::string path)
+    : path_(std::move(path))
+{
+    load_header();
+}
+
+bool RegionFile::hasChunk(glm::ivec2 local_pos) const
+{
+    return entries_[get_entry_index(local_pos)].offset != 0;
+}
+
+uint32_t RegionFile::getChunkOffset(glm::ivec2 local_pos) const
+{
+    return entries_[get_entry_index(local_pos)].offset;
+}
+
+const uint8_t *RegionFile::readChunk(glm::ivec2 local_pos, uint32_t &out_size)
+{
+    const Entry &entry = entries_[get_entry_index(local_pos)];
+    if (entry.offset == 0)
+    {
+        return nullptr;
+    }
+
+    flush();
+    if (!mapped_.isOpen() && !mapped_.open(path_.c_str()))
+    {
+        return nullptr;
+    }
+    if ((uint64_t)entry.offset + entry.size > mapped_.getSize())
+    {
+        assert(false && "Corrupted region file");
+        return nullptr;
+    }
+
+    out_size = entry.size;
+    return mapped_.getData() + entry.offset;
+}
+
+bool RegionFile::writeChunk(glm::ivec2 local_pos, const uint8_t *data, uint32_t size)
+{
+    assert(size > 0);
+
+    // The file is going to change, the old mapping can't be used
+    mapped_.close();
+
+    if (file_end_ == 0 && !create_file())
+    {
+        return false;
+    }
+
+    if (!write_file_.is_open())
+    {
+        write_file_.open(path_, std::ios::in | std::ios::out | std::ios::binary);
+        if (!write_file_)
+        {
+            write_file_.close();
+            return false;
+        }
+    }
+    std::fstream &file = write_file_;
+
+    const int entry_index = get_entry_index(local_pos);
+    Entry entry = entries_[entry_index];
+    const bool append = size > entry.capacity;
+    if (append)
+    {
+        entry.offset = file_end_;
+        entry.capacity = (size + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+    }
+    entry.size = size;
+
+    file.seekp(entry.offset);
+    file.write(reinterpret_cast<const char *>(data), size);
+    if (append)
+    {
+        // Keep the whole capacity in the file, the next payload is appended after it
+        static const char zeros[PAYLOAD_ALIGNMENT] = {};
+        file.write(zeros, entry.capacity - size);
+    }
+
+    // The entry is updated last, an appended payload isn't referenced if the write fails
+    file.seekp(sizeof(Header) + entry_index * sizeof(Entry));
+    file.write(reinterpret_cast<const char *>(&entry), sizeof(Entry));
+    if (!file)
+    {
+        write_file_.close();
+        return false;
+    }
+
+    entries_[entry_index] = entry;
+    if (append)
+    {
+        file_end_ = entry.offset + entry.capacity;
+    }
+    return true;
+}
+
+void RegionFile::flush()
+{
+    if (write_file_.is_open())
+    {
+        write_file_.close();
+    }
+}
+
+void RegionFile::load_header()
+{
+    std::fill(std::begin(entries_), std::end(entries_), Entry{});
+    file_end_ = 0;
+
+    if (!mapped_.open(path_.c_str()))
+    {
+        return;
+    }
+
+    const uint64_t header_size = sizeof(Header) + sizeof(entries_);
+    if (mapped_.getSize() < header_size)
+    {
+        return;
+    }
+
+    Header header;
+    memcpy(&header, mapped_.getData(), sizeof(Header));
+    if (header.magic != REGION_MAGIC || header.version != REGION_VERSION)
+    {
+        return;
+    }
+    memcpy(entries_, mapped_.getData() + sizeof(Header), sizeof(entries_));
+
+    uint64_t file_end = header_size;
+    for (Entry &entry : entries_)
+    {
+        if (entry.offset == 0)
+        {
+            continue;
+        }
+        const uint64_t end = (uint64_t)entry.offset + entry.capacity;
+        if (entry.offset < header_size || entry.size > entry.capacity || end > mapped_.getSize())
+        {
+            entry = Entry{};
+            continue;
+        }
+        file_end = std::max(file_end, end);
+    }
+    file_end_ = (uint32_t)file_end;
+}
+
+bool RegionFile::create_file()
+{
+    std::fill(std::begin(entries_), std::end(entries_), Entry{});
+
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    const Header header{REGION_MAGIC, REGION_VERSION};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char *>(entries_), sizeof(entries_));
+    if (!file)
+    {
+        return false;
+    }
+
+    file_end_ = sizeof(Header) + sizeof(entries_);
+    return true;
+}
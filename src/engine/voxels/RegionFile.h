@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Base.h"
+#include "fs/MappedFile.h"
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// REGION_WIDTH x REGION_WIDTH chunks in one file. The header is a table of chunk entries followed
+// by the chunk payloads. Payloads are read from the memory mapped file, a payload is rewritten in
+// place if it fits the allocated space, otherwise it's appended to the end of the file.
+class RegionFile
+{
+public:
+    static constexpr int REGION_WIDTH = 32;
+    static constexpr int NUM_CHUNKS = REGION_WIDTH * REGION_WIDTH;
+
+    explicit RegionFile(std::string path);
+
+    REMOVE_COPY_MOVE_CLASS(RegionFile);
+
+    bool hasChunk(glm::ivec2 local_pos) const;
+    // Offset of the payload in the file, 0 if the chunk isn't stored
+    uint32_t getChunkOffset(glm::ivec2 local_pos) const;
+
+    // Returns null if the chunk isn't stored. The data is valid until the next write
+    const uint8_t *readChunk(glm::ivec2 local_pos, uint32_t &out_size);
+    // The file stays opened for the next writes until flush() or readChunk()
+    bool writeChunk(glm::ivec2 local_pos, const uint8_t *data, uint32_t size);
+    void flush();
+
+private:
+    struct Entry
+    {
+        uint32_t offset{0}; // 0 - the chunk isn't stored
+        uint32_t size{0};
+        uint32_t capacity{0};
+    };
+
+    static REALENGINE_INLINE int get_entry_index(glm::ivec2 local_pos)
+    {
+        assert(local_pos.x >= 0 && local_pos.x < REGION_WIDTH);
+        assert(local_pos.y >= 0 && local_pos.y < REGION_WIDTH);
+        return local_pos.x + local_pos.y * REGION_WIDTH;
+    }
+
+    void load_header();
+    bool create_file();
+
+private:
+    std::string path_;
+    MappedFile mapped_;
+    std::fstream write_file_;
+
+    Entry entries_[NUM_CHUNKS];
+    uint32_t file_end_{0}; // 0 - the file doesn't exist or is invalid
+};
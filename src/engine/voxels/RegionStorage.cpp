@@ -0,0 +1,138 @@
+#include "RegionStorage.h"
+
+#include "Chunk.h"
+#include "ChunkCodec.h"
+#include "RegionFile.h"
+#include "math/Math.h"
+#include "profiler/ScopedProfiler.h"
+#include "utils/Algos.h"
+
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+
+REALENGINE_INLINE glm::ivec2 get_region_pos(glm::ivec2 chunk_pos)
+{
+    return {math::floorToCell(chunk_pos.x, RegionFile::REGION_WIDTH),
+        math::floorToCell(chunk_pos.y, RegionFile::REGION_WIDTH)};
+}
+
+REALENGINE_INLINE glm::ivec2 get_local_pos(glm::ivec2 chunk_pos, glm::ivec2 region_pos)
+{
+    return chunk_pos - region_pos * RegionFile::REGION_WIDTH;
+}
+
+} // namespace
+
+RegionStorage::RegionStorage(std::string directory, int num_block_ids)
+    : directory_(std::move(directory))
+    , num_block_ids_(num_block_ids)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    assert(!ec);
+}
+
+RegionStorage::~RegionStorage() = default;
+
+bool RegionStorage::loadChunk(Chunk &chunk, uint64_t &out_bytes_read)
+{
+    SCOPED_FUNC_PROFILER;
+
+    const glm::ivec2 pos = chunk.getPositionXZ();
+    const glm::ivec2 region_pos = get_region_pos(pos);
+
+    std::lock_guard lock(mutex_);
+    RegionFile &region = get_region(region_pos);
+
+    uint32_t size = 0;
+    const uint8_t *data = region.readChunk(get_local_pos(pos, region_pos), size);
+    if (!data)
+    {
+        return false;
+    }
+
+    out_bytes_read = size;
+    const bool loaded = ChunkCodec::decode(data, size, num_block_ids_, chunk);
+    if (!loaded)
+    {
+        // The chunk is cleared, it's generated again as if it wasn't stored
+        std::cout << "Corrupted chunk data, the chunk is regenerated: " << pos.x << " " << pos.y
+                  << " in " << directory_ << std::endl;
+    }
+    chunk.modified_ = false;
+    return loaded;
+}
+
+uint64_t RegionStorage::saveChunks(std::vector<ChunkData> &chunks)
+{
+    SCOPED_FUNC_PROFILER;
+
+    std::lock_guard lock(mutex_);
+
+    struct SortKey
+    {
+        glm::ivec2 region_pos;
+        uint32_t offset; // appended payloads go last
+        int index;
+    };
+    std::vector<SortKey> keys;
+    keys.reserve(chunks.size());
+    for (int i = 0; i < (int)chunks.size(); ++i)
+    {
+        const glm::ivec2 pos = chunks[i].pos;
+        const glm::ivec2 region_pos = get_region_pos(pos);
+        const uint32_t offset = get_region(region_pos).getChunkOffset(
+            get_local_pos(pos, region_pos));
+        keys.push_back({region_pos, offset != 0 ? offset : UINT32_MAX, i});
+    }
+    Alg::sort(keys, [](const SortKey &lhs, const SortKey &rhs) {
+        if (lhs.region_pos.x != rhs.region_pos.x)
+        {
+            return lhs.region_pos.x < rhs.region_pos.x;
+        }
+        if (lhs.region_pos.y != rhs.region_pos.y)
+        {
+            return lhs.region_pos.y < rhs.region_pos.y;
+        }
+        return lhs.offset < rhs.offset;
+    });
+
+    uint64_t bytes_written = 0;
+    RegionFile *prev_region = nullptr;
+    for (const SortKey &key : keys)
+    {
+        const ChunkData &chunk = chunks[key.index];
+        RegionFile &region = get_region(key.region_pos);
+        if (prev_region && prev_region != &region)
+        {
+            prev_region->flush();
+        }
+        prev_region = &region;
+
+        const glm::ivec2 local_pos = get_local_pos(chunk.pos, key.region_pos);
+        const bool saved = region.writeChunk(local_pos, chunk.data.data(),
+            (uint32_t)chunk.data.size());
+        assert(saved);
+        bytes_written += saved ? chunk.data.size() : 0;
+    }
+    if (prev_region)
+    {
+        prev_region->flush();
+    }
+    return bytes_written;
+}
+
+RegionFile &RegionStorage::get_region(glm::ivec2 region_pos)
+{
+    UPtr<RegionFile> &region = regions_[region_pos];
+    if (!region)
+    {
+        const std::string name = "r." + std::to_string(region_pos.x) + "."
+            + std::to_string(region_pos.y) + ".region";
+        region = makeU<RegionFile>(directory_ + '/' + name);
+    }
+    return *region;
+}
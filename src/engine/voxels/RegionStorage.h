@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Base.h"
+#include "utils/Hashers.h"
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Chunk;
+class RegionFile;
+
+// Modified chunks of a world stored in region files of the directory. Thread safe
+class RegionStorage
+{
+public:
+    struct ChunkData
+    {
+        glm::ivec2 pos{};
+        std::vector<uint8_t> data; // ChunkCodec::encode() result
+    };
+
+public:
+    // Loaded chunks with block ids out of [0, num_block_ids) are rejected
+    RegionStorage(std::string directory, int num_block_ids);
+    ~RegionStorage();
+
+    REMOVE_COPY_MOVE_CLASS(RegionStorage);
+
+    // Returns false if the chunk at the chunk's position isn't stored or its data is corrupted,
+    // the chunk is left cleared then
+    bool loadChunk(Chunk &chunk, uint64_t &out_bytes_read);
+
+    // Written sorted by the regions and the file offsets, so the writes are mostly sequential.
+    // Returns the number of written bytes
+    uint64_t saveChunks(std::vector<ChunkData> &chunks);
+
+    const std::string &getDirectory() const { return directory_; }
+
+private:
+    RegionFile &get_region(glm::ivec2 region_pos);
+
+private:
+    std::string directory_;
+    int num_block_ids_;
+
+    std::mutex mutex_;
+    std::unordered_map<glm::ivec2, UPtr<RegionFile>> regions_;
+};
@@ -0,0 +1,270 @@
+#include "TerrainGenerator.h"
+
+#include "BasicBlocks.h"
+#include "BlockInfo.h"
+#include "Chunk.h"
+#include "noise/BatchNoise.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr float BASE_FREQ = 0.002f;
+
+constexpr int MIN = 40;
+constexpr int HEIGHT = 180;
+constexpr int MAX = MIN + HEIGHT;
+
+constexpr int SNOW_OFFSET = MAX - 20;
+constexpr int SNOW_APLITUDE = 15;
+
+constexpr int HEIGHT_DISPLACE_AMPLITUDE = 120;
+
+static_assert(MIN < MAX && MAX < Chunk::CHUNK_HEIGHT && SNOW_OFFSET < Chunk::CHUNK_HEIGHT);
+
+} // namespace
+
+TerrainGenerator::TerrainGenerator(unsigned int seed)
+    : seed_(seed)
+{
+    const int s = (int)seed;
+
+    // Snow height map
+    base_snow_.SetSeed(s);
+    base_snow_.SetFrequency(BASE_FREQ * 3);
+    base_snow_.SetPersistence(0.7);
+
+    snow_final_blocks_.SetSourceModule(0, base_snow_);
+    snow_final_blocks_.SetMinAndHeight(SNOW_OFFSET, SNOW_APLITUDE);
+
+    // Height map
+    mountain_.SetSeed(s);
+    mountain_.SetFrequency(BASE_FREQ);
+
+    base_flat_.SetSeed(s);
+    base_flat_.SetFrequency(BASE_FREQ * 2.2);
+
+    flat_.SetSourceModule(0, base_flat_);
+    flat_.SetScale(0.095);
+    flat_.SetBias(-0.95);
+
+    type_.SetSeed(s);
+    type_.SetFrequency(BASE_FREQ * 0.8);
+    type_.SetPersistence(0.4);
+
+    selector_.SetSourceModule(0, flat_);
+    selector_.SetSourceModule(1, mountain_);
+    selector_.SetControlModule(type_);
+    selector_.SetBounds(0.4, 1000);
+    selector_.SetEdgeFalloff(0.1);
+
+    turbulence_.SetSeed(s);
+    turbulence_.SetSourceModule(0, selector_);
+    turbulence_.SetFrequency(BASE_FREQ * 4);
+    turbulence_.SetPower(4);
+
+    non_displacement_height_blocks_.SetSourceModule(0, turbulence_);
+    non_displacement_height_blocks_.SetMinAndHeight(MIN, HEIGHT);
+
+    height_displace_perlin_.SetSeed(s);
+    height_displace_perlin_.SetFrequency(BASE_FREQ * 0.05);
+    height_displace_perlin_.SetOctaveCount(5);
+    height_displace_perlin_.SetPersistence(0.7);
+
+    height_displace_blocks_.SetSourceModule(0, height_displace_perlin_);
+    height_displace_blocks_.SetMinAndHeight(0, HEIGHT_DISPLACE_AMPLITUDE);
+
+    height_final_blocks_.SetSourceModule(0, non_displacement_height_blocks_);
+    height_final_blocks_.SetSourceModule(1, height_displace_blocks_);
+
+    // Caves
+    cave_base_.SetSeed(s);
+    cave_base_.SetLacunarity(0.5);
+    cave_base_.SetFrequency(BASE_FREQ * 4);
+    cave_base_.SetOctaveCount(4);
+
+    cave_.SetSeed(s);
+    cave_.SetSourceModule(0, cave_base_);
+    cave_.SetFrequency(BASE_FREQ * 3);
+    cave_.SetPower(20);
+
+    setCaveLatticeStep(1);
+}
+
+TerrainGenerator &TerrainGenerator::getThreadGenerator(unsigned int seed)
+{
+    static thread_local UPtr<TerrainGenerator> generator;
+    if (!generator || generator->getSeed() != seed)
+    {
+        generator = makeU<TerrainGenerator>(seed);
+    }
+    return *generator;
+}
+
+void TerrainGenerator::setCaveLatticeStep(int step)
+{
+    assert(step >= 1 && step <= Chunk::CHUNK_WIDTH && (step & (step - 1)) == 0);
+    cave_lattice_step_ = step;
+    cave_lattice_shift_ = 0;
+    while ((1 << cave_lattice_shift_) < step)
+    {
+        ++cave_lattice_shift_;
+    }
+    cave_lattice_width_ = Chunk::CHUNK_WIDTH / step + 1;
+}
+
+void TerrainGenerator::generate(Chunk &chunk)
+{
+    const glm::vec2 chunk_pos = glm::vec2(chunk.getBlocksOffset());
+    const glm::vec2 chunk_end = glm::vec2(chunk.getBlocksEndOffset());
+
+#ifndef NDEBUG
+    if (!batch_noise_checked_)
+    {
+        batch_noise_checked_ = true;
+        assert(getMaxBatchNoiseError(chunk_pos) < MAX_BATCH_NOISE_ERROR);
+    }
+#endif
+
+    noise::batch::BuildPlane(snow_final_blocks_, chunk_pos.x, chunk_end.x, chunk_pos.y,
+        chunk_end.y, Chunk::CHUNK_WIDTH, Chunk::CHUNK_WIDTH, snow_map_);
+    noise::batch::BuildPlane(height_final_blocks_, chunk_pos.x, chunk_end.x, chunk_pos.y,
+        chunk_end.y, Chunk::CHUNK_WIDTH, Chunk::CHUNK_WIDTH, height_map_);
+
+    // Sections above the terrain stay empty, no need to visit them
+    int max_height = 0;
+    for (int z = 0; z < Chunk::CHUNK_WIDTH; ++z)
+    {
+        for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+        {
+            max_height = std::max(max_height, (int)height_map_[x + z * Chunk::CHUNK_WIDTH]);
+        }
+    }
+    const int max_y = std::min(max_height + 1, Chunk::CHUNK_HEIGHT);
+
+    const bool use_cave_lattice = cave_lattice_step_ > 1;
+    if (use_cave_lattice)
+    {
+        sample_cave_lattice(chunk_pos, max_y);
+    }
+
+    int block_index = -1;
+    for (int y = 0; y < max_y; ++y)
+    {
+        const double y_glob = (double)y;
+        for (int z = 0; z < Chunk::CHUNK_WIDTH; ++z)
+        {
+            const double z_glob = (double)z + chunk_pos.y;
+            for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+            {
+                const double x_glob = (double)x + chunk_pos.x;
+                ++block_index;
+                const int height = (int)height_map_[x + z * Chunk::CHUNK_WIDTH];
+                const int diff = y - height;
+
+                // The chunk is cleared, air blocks can be skipped
+                if (diff > 0)
+                {
+                    continue;
+                }
+
+                const double cave_value = use_cave_lattice
+                    ? get_cave_density(x, y, z)
+                    : cave_.GetValue(x_glob, y_glob, z_glob);
+                // if (cave_value < -0.6 && cave_value > -0.8)
+                // if (cave_value > 0.1 && cave_value < 0.7)
+                if (cave_value > 20)
+                {
+                    continue;
+                }
+
+                BlockInfo block;
+                const int snow_pos = (int)snow_map_[x + z * Chunk::CHUNK_WIDTH];
+                if (y > snow_pos)
+                {
+                    block = BlockInfo(BasicBlocks::SNOW);
+                }
+                else if (diff == 0)
+                {
+                    block = BlockInfo(BasicBlocks::GRASS);
+                }
+                else if (diff > -4)
+                {
+                    block = BlockInfo(BasicBlocks::DIRT);
+                }
+                else
+                {
+                    block = BlockInfo(BasicBlocks::STONE);
+                }
+                chunk.setBlock(block_index, block);
+            }
+        }
+    }
+}
+
+void TerrainGenerator::sample_cave_lattice(const glm::vec2 &chunk_pos, int max_y)
+{
+    const int step = cave_lattice_step_;
+    const int width = cave_lattice_width_;
+    // Enough layers to interpolate the top block
+    const int height = ((std::max(max_y, 1) - 1) >> cave_lattice_shift_) + 2;
+
+    cave_lattice_.resize(width * width * height);
+
+    int index = 0;
+    for (int ly = 0; ly < height; ++ly)
+    {
+        const double y_glob = (double)(ly * step);
+        for (int lz = 0; lz < width; ++lz)
+        {
+            const double z_glob = (double)(lz * step) + chunk_pos.y;
+            for (int lx = 0; lx < width; ++lx)
+            {
+                const double x_glob = (double)(lx * step) + chunk_pos.x;
+                cave_lattice_[index++] = (float)cave_.GetValue(x_glob, y_glob, z_glob);
+            }
+        }
+    }
+}
+
+float TerrainGenerator::get_cave_density(int x, int y, int z) const
+{
+    const int shift = cave_lattice_shift_;
+    const int mask = cave_lattice_step_ - 1;
+    const float inv_step = 1.0f / (float)cave_lattice_step_;
+
+    const int lx = x >> shift;
+    const int ly = y >> shift;
+    const int lz = z >> shift;
+    const float fx = (float)(x & mask) * inv_step;
+    const float fy = (float)(y & mask) * inv_step;
+    const float fz = (float)(z & mask) * inv_step;
+
+    const int width = cave_lattice_width_;
+    const int layer = width * width;
+    const float *v = cave_lattice_.data() + lx + lz * width + ly * layer;
+
+    const auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+    const float v00 = lerp(v[0], v[1], fx);
+    const float v10 = lerp(v[width], v[width + 1], fx);
+    const float v01 = lerp(v[layer], v[layer + 1], fx);
+    const float v11 = lerp(v[layer + width], v[layer + width + 1], fx);
+    return lerp(lerp(v00, v10, fz), lerp(v01, v11, fz), fy);
+}
+
+double TerrainGenerator::getMaxBatchNoiseError(const glm::vec2 &chunk_pos) const
+{
+    constexpr int NUM_POINTS = Chunk::CHUNK_WIDTH * Chunk::CHUNK_WIDTH;
+    double x[NUM_POINTS];
+    double y[NUM_POINTS];
+    double z[NUM_POINTS];
+    for (int i = 0; i < NUM_POINTS; ++i)
+    {
+        x[i] = chunk_pos.x + (double)(i % Chunk::CHUNK_WIDTH);
+        y[i] = 0.0;
+        z[i] = chunk_pos.y + (double)(i / Chunk::CHUNK_WIDTH);
+    }
+    return std::max(noise::batch::GetMaxError(snow_final_blocks_, x, y, z, NUM_POINTS),
+        noise::batch::GetMaxError(height_final_blocks_, x, y, z, NUM_POINTS));
+}
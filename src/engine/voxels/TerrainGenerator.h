@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Base.h"
+#include "Chunk.h"
+#include "noise/MapToMinMax.h"
+
+#include <glm/vec2.hpp>
+#include <noise/noise.h>
+
+#include <vector>
+
+// Noise modules graph of the terrain, reused by a thread for all its chunks. Building it takes
+// about a microsecond, much less than a chunk's generation (see the "terrain" bench mode), the
+// reuse only keeps the cave lattice allocation. Not thread safe: GetValue doesn't modify the
+// modules, but the height maps are shared
+class TerrainGenerator
+{
+public:
+    // In blocks, the batch noise values are calculated in floats
+    static constexpr double MAX_BATCH_NOISE_ERROR = 0.01;
+
+    explicit TerrainGenerator(unsigned int seed);
+
+    REMOVE_COPY_MOVE_CLASS(TerrainGenerator);
+
+    // Generator owned by the calling thread, rebuilt only when the seed changes
+    static TerrainGenerator &getThreadGenerator(unsigned int seed);
+
+    unsigned int getSeed() const { return seed_; }
+
+    // The cave noise is sampled on a lattice with the step (in blocks) and interpolated for the
+    // blocks between. Must be a power of two <= CHUNK_WIDTH, 1 - sample every block
+    void setCaveLatticeStep(int step);
+    int getCaveLatticeStep() const { return cave_lattice_step_; }
+
+    // The chunk must be cleared
+    void generate(Chunk &chunk);
+
+    // Max difference in blocks between the batch and the scalar libnoise height maps of the chunk
+    double getMaxBatchNoiseError(const glm::vec2 &chunk_pos) const;
+
+private:
+    void sample_cave_lattice(const glm::vec2 &chunk_pos, int max_y);
+    float get_cave_density(int x, int y, int z) const;
+
+private:
+    unsigned int seed_{0};
+
+    // Snow height map
+    noise::module::Billow base_snow_;
+    noise::module::MapToMinMax snow_final_blocks_;
+    float snow_map_[Chunk::CHUNK_WIDTH * Chunk::CHUNK_WIDTH];
+
+    // Height map
+    noise::module::RidgedMulti mountain_;
+    noise::module::Billow base_flat_;
+    noise::module::ScaleBias flat_;
+    noise::module::Perlin type_;
+    noise::module::Select selector_;
+    noise::module::Turbulence turbulence_;
+    noise::module::MapToMinMax non_displacement_height_blocks_;
+    noise::module::Perlin height_displace_perlin_;
+    noise::module::MapToMinMax height_displace_blocks_;
+    noise::module::Add height_final_blocks_;
+    float height_map_[Chunk::CHUNK_WIDTH * Chunk::CHUNK_WIDTH];
+
+    // Caves
+    noise::module::RidgedMulti cave_base_;
+    noise::module::Turbulence cave_;
+
+    int cave_lattice_step_{1};
+    int cave_lattice_shift_{0};
+    int cave_lattice_width_{0};
+    std::vector<float> cave_lattice_; // XZY
+
+#ifndef NDEBUG
+    bool batch_noise_checked_{false};
+#endif
+};
@@ -10,30 +10,34 @@
 #include "Camera.h"
 #include "Chunk.h"
 #include "ChunkMesh.h"
+#include "ChunkMeshData.h"
 #include "ChunkMeshGenerator.h"
+#include "ChunkIO.h"
+#include "ChunkMeshSnapshot.h"
 #include "Common.h"
 #include "EngineGlobals.h"
 #include "GlobalLight.h"
 #include "MaterialManager.h"
+#include "RegionStorage.h"
 #include "Shader.h"
 #include "ShaderManager.h"
 #include "ShaderSource.h"
+#include "TerrainGenerator.h"
 #include "TextureManager.h"
 #include "VertexArrayObject.h"
 #include "Visualizer.h"
+#include "fs/FileSystem.h"
 #include "math/IntersectionMath.h"
 #include "math/Math.h"
-#include "noise/MapToMinMax.h"
 #include "profiler/ScopedProfiler.h"
 #include "profiler/ScopedTimer.h"
 #include "threads/Job.h"
 #include "threads/JobQueue.h"
+#include "threads/Parallel.h"
 #include "threads/Threads.h"
+#include "time/Time.h"
 #include "utils/Algos.h"
 
-#include <noise/noise.h>
-#include <noise/noiseutils.h>
-
 #include <glm/ext/matrix_transform.hpp>
 
 
@@ -42,12 +46,19 @@ namespace
 
 #ifndef NDEBUG
 constexpr int MAX_INIT_CHUNKS_PER_UPDATE = 30;
-constexpr int MAX_REGENERATED_MESHES_PER_UPDATE = 2;
 #else
 constexpr int MAX_INIT_CHUNKS_PER_UPDATE = 100;
-constexpr int MAX_REGENERATED_MESHES_PER_UPDATE = 10;
 #endif
 
+// Enough to keep the workers busy, but the nearest chunks are still enqueued first
+constexpr int MAX_MESH_JOBS_PER_THREAD = 4;
+
+// Window of the chunk I/O bytes/s statistics
+constexpr double IO_STATS_PERIOD_SEC = 0.5;
+
+// Chunks tested against the frustum by one culling job
+constexpr int CULLING_GRAIN = 256;
+
 constexpr int MULTIPLIER = 20;
 constexpr int RADIUS_SPAWN_CHUNK = 2 * MULTIPLIER;
 constexpr int RADIUS_UNLOAD_MESH = 3 * MULTIPLIER;
@@ -59,14 +70,14 @@ static_assert(RADIUS_UNLOAD_WHOLE_CHUNK > RADIUS_UNLOAD_MESH
 
 } // namespace
 
-struct VoxelEngine::Perlin
-{
-    explicit Perlin() {}
-};
-
 VoxelEngine::VoxelEngine() = default;
 
-VoxelEngine::~VoxelEngine() = default;
+VoxelEngine::~VoxelEngine()
+{
+    saveModifiedChunks();
+    // Writes the pending saves
+    io_.reset();
+}
 
 void VoxelEngine::setAmbientOcclusionEnabled(bool enabled)
 {
@@ -92,6 +103,35 @@ bool VoxelEngine::isAmbientOcclusionEnabled() const
     return !shader_->getDefines().empty();
 }
 
+void VoxelEngine::setGreedyMeshingEnabled(bool enabled)
+{
+    if (enabled == isGreedyMeshingEnabled())
+    {
+        return;
+    }
+
+    greedy_meshing_ = enabled;
+
+    for (const UPtr<Chunk> &chunk : chunks_map_.getChunks())
+    {
+        if (chunk && chunk->mesh_)
+        {
+            chunk->need_rebuild_mesh_ = true;
+        }
+    }
+}
+
+bool VoxelEngine::isGreedyMeshingEnabled() const
+{
+    return greedy_meshing_;
+}
+
+void VoxelEngine::setCaveLatticeStep(int step)
+{
+    assert(step >= 1 && step <= Chunk::CHUNK_WIDTH && (step & (step - 1)) == 0);
+    cave_lattice_step_ = step;
+}
+
 void VoxelEngine::init()
 {
     chunks_map_.setUnloadCallback(
@@ -99,10 +139,11 @@ void VoxelEngine::init()
     chunks_map_.setRadius(RADIUS_UNLOAD_WHOLE_CHUNK);
     chunks_map_.setCenter(last_base_chunk_pos_);
 
-    perlin_ = makeU<Perlin>();
-
     registry_ = makeU<BlocksRegistry>();
-    register_blocks();
+    BasicBlocks::registerBlocks(*registry_);
+
+    create_storage();
+    io_ = makeU<ChunkIO>();
 
     Texture *atlas = eng.texture_manager->create("atlas");
     // TODO# generate mip maps! but custom
@@ -115,7 +156,6 @@ void VoxelEngine::init()
     atlas->load("vox/atlas.png", Texture::FlipMode::FlipY, params);
 
     registry_->setAtlas(atlas, glm::ivec2(16, 16));
-    registry_->flush();
 
     // shader
     shader_source_ = eng.shader_manager->create("vox shader");
@@ -169,15 +209,33 @@ void VoxelEngine::update(const glm::vec3 &position)
     };
 
     {
-        SCOPED_PROFILER("Cancel chunks jobs");
+        SCOPED_PROFILER("Cancel and reprioritize chunks jobs");
         for (EnqueuedChunk &c : enqueued_chunks_)
         {
-            assert(c.cancel_token.isAlive());
-            if (chunk_pos_changed || is_outside_radius(c.pos.x, c.pos.y, RADIUS_UNLOAD_WHOLE_CHUNK))
+            if (is_outside_radius(c.pos.x, c.pos.y, RADIUS_UNLOAD_WHOLE_CHUNK))
+            {
+                c.handle.cancel();
+            }
+            else if (chunk_pos_changed)
+            {
+                c.handle.setPriorityKey(get_distance2(c.pos.x, c.pos.y));
+            }
+        }
+        for (EnqueuedChunk &c : enqueued_meshes_)
+        {
+            if (is_outside_radius(c.pos.x, c.pos.y, RADIUS_UNLOAD_MESH))
+            {
+                c.handle.cancel();
+            }
+            else if (chunk_pos_changed)
             {
-                c.cancel_token.cancel();
+                c.handle.setPriorityKey(get_distance2(c.pos.x, c.pos.y));
             }
         }
+        if (chunk_pos_changed)
+        {
+            eng.queue->updatePriorities();
+        }
     }
 
     {
@@ -194,7 +252,7 @@ void VoxelEngine::update(const glm::vec3 &position)
                 }
                 if (is_chunk_outside_radius(*chunk, RADIUS_UNLOAD_MESH))
                 {
-                    release_mesh(std::move(chunk->mesh_));
+                    release_mesh(*chunk);
                 }
             }
         }
@@ -206,27 +264,24 @@ void VoxelEngine::update(const glm::vec3 &position)
         if (chunk_pos_changed || old_num_inited_chunks_ != 0)
         {
             int num_inited_chunks = 0;
+            // Slots still used by the jobs of the chunks outside of the radius, try next update
+            int num_blocked_chunks = 0;
 
-            const std::vector<glm::ivec2> offsets = offsets_cache.getOffsets(RADIUS_SPAWN_CHUNK);
+            const std::vector<glm::ivec2> &offsets = offsets_cache.getOffsets(RADIUS_SPAWN_CHUNK);
             for (const glm::ivec2 &offset : offsets)
             {
-                const int x = base_chunk_pos.x + offset.x;
-                const int z = base_chunk_pos.z + offset.y;
+                const glm::ivec2 pos{base_chunk_pos.x + offset.x, base_chunk_pos.z + offset.y};
 
-                assert(!is_outside_radius(x, z, RADIUS_SPAWN_CHUNK));
+                assert(!is_outside_radius(pos.x, pos.y, RADIUS_SPAWN_CHUNK));
 
-                // NOTE: chunk_index_by_pos_ has invalid values here! but we can use it in this case
-                if (has_chunk_at_pos(x, z))
-                {
-                    continue;
-                }
-                if (is_enqued_for_generation(x, z))
+                // Loaded, enqueued for generation or generated
+                if (chunks_map_.getChunkState(pos) != ChunksMap::ChunkState::None)
                 {
                     continue;
                 }
-                // TODO# shitty
-                if (is_generated(x, z))
+                if (chunks_map_.isSlotBusy(pos))
                 {
+                    ++num_blocked_chunks;
                     continue;
                 }
 
@@ -235,11 +290,11 @@ void VoxelEngine::update(const glm::vec3 &position)
                     continue;
                 }
 
-                UPtr<Chunk> new_chunk = get_chunk_cached(glm::ivec3{x, 0, z});
+                UPtr<Chunk> new_chunk = get_chunk_cached(glm::ivec3{pos.x, 0, pos.y});
                 chunks_to_generate_.push_back(std::move(new_chunk));
                 ++num_inited_chunks;
             }
-            old_num_inited_chunks_ = num_inited_chunks;
+            old_num_inited_chunks_ = num_inited_chunks + num_blocked_chunks;
         }
     }
 
@@ -253,6 +308,36 @@ void VoxelEngine::update(const glm::vec3 &position)
         canceled_chunks_.clear();
     }
 
+    {
+        SCOPED_PROFILER("Take loaded chunks");
+
+        std::vector<ChunkIO::LoadResult> load_results;
+        io_->takeLoadResults(load_results);
+        for (ChunkIO::LoadResult &result : load_results)
+        {
+            UPtr<Chunk> &chunk = result.chunk;
+            const glm::ivec2 pos = chunk->getPositionXZ();
+            assert(is_enqued_for_generation(pos.x, pos.y));
+
+            if (result.loaded)
+            {
+                chunk->need_rebuild_mesh_ = true;
+                chunks_map_.setChunkState(pos, ChunksMap::ChunkState::Generated);
+                generated_chunks_.push_back(std::move(chunk));
+            }
+            else if (is_chunk_outside_radius(*chunk, RADIUS_UNLOAD_WHOLE_CHUNK))
+            {
+                chunks_map_.setChunkState(pos, ChunksMap::ChunkState::None);
+                release_chunk(std::move(chunk));
+            }
+            else
+            {
+                const int distance2 = get_chunk_distance2(*chunk);
+                queue_generate_chunk(std::move(chunk), distance2);
+            }
+        }
+    }
+
     // TODO# move upper?
     {
         SCOPED_PROFILER("Add generated chunks");
@@ -260,20 +345,23 @@ void VoxelEngine::update(const glm::vec3 &position)
         {
             assert(chunk);
 
+            const glm::ivec2 pos = chunk->getPositionXZ();
+            assert(is_generated(pos.x, pos.y));
+
             if (is_chunk_outside_radius(*chunk, RADIUS_UNLOAD_WHOLE_CHUNK))
             {
+                chunks_map_.setChunkState(pos, ChunksMap::ChunkState::None);
                 release_chunk(std::move(chunk));
                 continue;
             }
 
-            const glm::ivec2 pos = chunk->getPositionXZ();
             chunks_map_.setChunkUnsafe(pos, std::move(chunk));
         }
         generated_chunks_.clear();
     }
 
     {
-        SCOPED_PROFILER("Enqueue new chunks for generation");
+        SCOPED_PROFILER("Enqueue new chunks for loading");
 
         {
             SCOPED_PROFILER("Sort by distance");
@@ -284,11 +372,13 @@ void VoxelEngine::update(const glm::vec3 &position)
 
         for (UPtr<Chunk> &chunk : chunks_to_generate_)
         {
-            queue_generate_chunk(std::move(chunk));
+            queue_load_chunk(std::move(chunk));
         }
         chunks_to_generate_.clear();
     }
 
+    update_io_stats();
+
     {
         SCOPED_PROFILER("Generate/unload meshes");
 
@@ -297,6 +387,9 @@ void VoxelEngine::update(const glm::vec3 &position)
         {
             SCOPED_PROFILER("add to chunks_for_regenerate_ and release");
 
+            uint64_t num_loaded_chunks = 0;
+            uint64_t loaded_chunks_memory = 0;
+
             // Generate/unload meshes for chunks according to neighbours chunks
             for (const UPtr<Chunk> &chunk : chunks_map_.getChunks())
             {
@@ -305,6 +398,9 @@ void VoxelEngine::update(const glm::vec3 &position)
                     continue;
                 }
 
+                ++num_loaded_chunks;
+                loaded_chunks_memory += chunk->getMemoryUsage();
+
                 ExtendedNeighbourChunks neighbours;
                 bool has_all = false;
                 get_neighbour_chunks_lazy(chunk.get(), neighbours, has_all);
@@ -313,7 +409,7 @@ void VoxelEngine::update(const glm::vec3 &position)
                 {
                     if (chunk->mesh_)
                     {
-                        release_mesh(std::move(chunk->mesh_));
+                        release_mesh(*chunk);
                     }
                     continue;
                 }
@@ -329,6 +425,8 @@ void VoxelEngine::update(const glm::vec3 &position)
                     chunks_for_regenerate_.push_back(chunk.get());
                 }
             }
+
+            eng.stat.setLoadedChunks(num_loaded_chunks, loaded_chunks_memory);
         }
 
         {
@@ -339,13 +437,21 @@ void VoxelEngine::update(const glm::vec3 &position)
         }
 
         {
-            SCOPED_PROFILER("Generate meshes");
+            SCOPED_PROFILER("Enqueue meshes");
 
-            int num_regenerated_meshes = 0;
+            const int max_mesh_jobs = std::max(eng.queue->getNumThreads(), 1)
+                * MAX_MESH_JOBS_PER_THREAD;
             for (Chunk *chunk : chunks_for_regenerate_)
             {
+                const glm::ivec3 pos = chunk->getPosition();
+                // Will be enqueued again after the current job if the chunk changed
+                if (is_enqueued_for_meshing(pos.x, pos.z))
+                {
+                    continue;
+                }
+
                 if (!chunk->need_rebuild_mesh_force_
-                    && num_regenerated_meshes >= MAX_REGENERATED_MESHES_PER_UPDATE)
+                    && (int)enqueued_meshes_.size() >= max_mesh_jobs)
                 {
                     continue;
                 }
@@ -363,12 +469,10 @@ void VoxelEngine::update(const glm::vec3 &position)
                     get_neighbour_chunks_lazy(chunk, neighbours, has_all);
                     assert(has_all);
 
-                    ChunkMeshGenerator generator;
-                    generator.rebuildMesh(*chunk, *chunk->mesh_, neighbours);
+                    queue_build_mesh(*chunk, neighbours, get_chunk_distance2(*chunk));
                     chunk->need_rebuild_mesh_ = false;
                     chunk->need_rebuild_mesh_force_ = false;
-
-                    num_regenerated_meshes++;
+                    chunk->clearDirtySections();
                 }
             }
         }
@@ -397,6 +501,12 @@ void VoxelEngine::update(const glm::vec3 &position)
     }
 #endif
 
+    PROFILER_COUNTER("Loaded chunks", eng.stat.getNumLoadedChunks());
+    PROFILER_COUNTER("Pooled chunks", chunks_pool_.size());
+    PROFILER_COUNTER("Pooled meshes", meshes_pool_.size());
+    PROFILER_COUNTER("Pooled mesh snapshots", mesh_snapshots_pool_.size());
+    PROFILER_COUNTER("Pooled mesh data", mesh_data_pool_.size());
+
     last_base_chunk_pos_ = base_chunk_pos;
 }
 
@@ -440,23 +550,30 @@ void VoxelEngine::render(Camera *camera, GlobalLight *sun_light)
     constexpr int atlas_index = 0;
     registry_->getAtlas()->bind(atlas_index);
     shader_->setUniformInt(atlas_loc, atlas_index);
+    shader_->setUniformVec2("uAtlasTileSize", registry_->getAtlasTileSize());
+    shader_->setUniformInt("uAtlasTilesPerRow", registry_->getAtlasTilesPerRow());
 
     {
         SCOPED_PROFILER("Culling");
-        chunks_for_render_.clear();
-        for (const UPtr<Chunk> &chunk : chunks_map_.getChunks())
-        {
-            if (!chunk || !chunk->mesh_)
+        const std::vector<UPtr<Chunk>> &chunks = chunks_map_.getChunks();
+        const FrustumPlanes &frustum_planes = camera->getFrustumPlanes();
+        chunks_visible_.resize(chunks.size());
+        tbb::parallelFor(0, (int)chunks.size(), CULLING_GRAIN, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
             {
-                continue;
+                const Chunk *chunk = chunks[i].get();
+                chunks_visible_[i] = chunk && chunk->mesh_
+                    && chunk->getBoundSphere().isInsideFrustum(frustum_planes);
             }
-            const math::BoundSphere &bound_sphere = chunk->getBoundSphere();
-            const bool inside = bound_sphere.isInsideFrustum(camera->getFrustumPlanes());
-            if (!inside)
+        });
+
+        chunks_for_render_.clear();
+        for (int i = 0; i < (int)chunks.size(); ++i)
+        {
+            if (chunks_visible_[i])
             {
-                continue;
+                chunks_for_render_.push_back(chunks[i].get());
             }
-            chunks_for_render_.push_back(chunk.get());
         }
     }
 
@@ -503,8 +620,29 @@ void VoxelEngine::render(Camera *camera, GlobalLight *sun_light)
 
 void VoxelEngine::setSeed(unsigned int seed)
 {
+    if (seed == seed_)
+    {
+        return;
+    }
+    saveModifiedChunks();
     seed_ = seed;
-    perlin_ = makeU<Perlin>();
+    if (storage_)
+    {
+        create_storage();
+    }
+}
+
+void VoxelEngine::saveModifiedChunks()
+{
+    SCOPED_FUNC_PROFILER;
+
+    for (UPtr<Chunk> &chunk : chunks_map_.getChunks())
+    {
+        if (chunk)
+        {
+            save_chunk(*chunk);
+        }
+    }
 }
 
 Material *VoxelEngine::getEnvironmentMaterial()
@@ -556,7 +694,7 @@ bool VoxelEngine::setBlockAtPosition(const glm::ivec3 &position, BlockInfo block
         return false;
     }
 
-    BlockInfo &b = chunk->getBlockRef(loc_pos.x, loc_pos.y, loc_pos.z);
+    Chunk::BlockRef b = chunk->getBlockRef(loc_pos.x, loc_pos.y, loc_pos.z);
     if (b == block)
     {
         return true;
@@ -564,6 +702,7 @@ bool VoxelEngine::setBlockAtPosition(const glm::ivec3 &position, BlockInfo block
 
     b = block;
     chunk->need_rebuild_mesh_force_ = true;
+    chunk->modified_ = true;
 
     if (loc_pos.x == 0)
     {
@@ -869,91 +1008,61 @@ void VoxelEngine::visitIntersection(const glm::vec3 &position, const glm::vec3 &
     }
 }
 
-void VoxelEngine::register_blocks()
+ChunkMesh *VoxelEngine::get_mesh_cached()
 {
-    BlocksRegistry &reg = *registry_;
-
-    {
-        BlockDescription &b = reg.addBlock();
-        BasicBlocks::AIR = b.id;
-        b.name = "Air";
-        b.type = BlockType::AIR;
-        b.texture_index_px = 0;
-        b.texture_index_nx = 0;
-        b.texture_index_py = 0;
-        b.texture_index_ny = 0;
-        b.texture_index_pz = 0;
-        b.texture_index_nz = 0;
-    }
-    {
-        BlockDescription &b = reg.addBlock();
-        BasicBlocks::DIRT = b.id;
-        b.name = "Dirt";
-        b.type = BlockType::SOLID;
-        b.texture_index_px = 2;
-        b.texture_index_nx = 2;
-        b.texture_index_py = 2;
-        b.texture_index_ny = 2;
-        b.texture_index_pz = 2;
-        b.texture_index_nz = 2;
-    }
-    {
-        BlockDescription &b = reg.addBlock();
-        BasicBlocks::GRASS = b.id;
-        b.name = "Grass";
-        b.type = BlockType::SOLID;
-        b.texture_index_px = 1;
-        b.texture_index_nx = 1;
-        b.texture_index_py = 0;
-        b.texture_index_ny = 2;
-        b.texture_index_pz = 1;
-        b.texture_index_nz = 1;
-    }
+    if (meshes_pool_.empty())
     {
-        BlockDescription &b = reg.addBlock();
-        BasicBlocks::STONE = b.id;
-        b.name = "Stone";
-        b.type = BlockType::SOLID;
-        b.texture_index_px = 3;
-        b.texture_index_nx = 3;
-        b.texture_index_py = 3;
-        b.texture_index_ny = 3;
-        b.texture_index_pz = 3;
-        b.texture_index_nz = 3;
+        meshes_.push_back(makeU<ChunkMesh>());
+        return meshes_.back().get();
     }
+    ChunkMesh *mesh = meshes_pool_.back();
+    meshes_pool_.pop_back();
+    assert(mesh);
+    mesh->reset();
+    return mesh;
+}
+
+void VoxelEngine::release_mesh(Chunk &chunk)
+{
+    assert(chunk.mesh_);
+    meshes_pool_.push_back(chunk.mesh_);
+    chunk.mesh_ = nullptr;
+}
+
+UPtr<ChunkMeshData> VoxelEngine::get_mesh_data_cached()
+{
+    if (mesh_data_pool_.empty())
     {
-        BlockDescription &b = reg.addBlock();
-        BasicBlocks::SNOW = b.id;
-        b.name = "Snow";
-        b.type = BlockType::SOLID;
-        b.texture_index_px = 4;
-        b.texture_index_nx = 4;
-        b.texture_index_py = 4;
-        b.texture_index_ny = 4;
-        b.texture_index_pz = 4;
-        b.texture_index_nz = 4;
+        return makeU<ChunkMeshData>();
     }
+    UPtr<ChunkMeshData> data = std::move(mesh_data_pool_.back());
+    mesh_data_pool_.pop_back();
+    assert(data);
+    return data;
+}
 
-    assert(BasicBlocks::AIR == 0);
+void VoxelEngine::release_mesh_data(UPtr<ChunkMeshData> data)
+{
+    assert(data);
+    mesh_data_pool_.push_back(std::move(data));
 }
 
-UPtr<ChunkMesh> VoxelEngine::get_mesh_cached()
+UPtr<ChunkMeshSnapshot> VoxelEngine::get_mesh_snapshot_cached()
 {
-    if (meshes_pool_.empty())
+    if (mesh_snapshots_pool_.empty())
     {
-        return makeU<ChunkMesh>();
+        return makeU<ChunkMeshSnapshot>();
     }
-    UPtr<ChunkMesh> mesh = std::move(meshes_pool_.back());
-    meshes_pool_.pop_back();
-    assert(mesh);
-    mesh->clear();
-    return mesh;
+    UPtr<ChunkMeshSnapshot> snapshot = std::move(mesh_snapshots_pool_.back());
+    mesh_snapshots_pool_.pop_back();
+    assert(snapshot);
+    return snapshot;
 }
 
-void VoxelEngine::release_mesh(UPtr<ChunkMesh> mesh)
+void VoxelEngine::release_mesh_snapshot(UPtr<ChunkMeshSnapshot> snapshot)
 {
-    assert(mesh);
-    meshes_pool_.push_back(std::move(mesh));
+    assert(snapshot);
+    mesh_snapshots_pool_.push_back(std::move(snapshot));
 }
 
 UPtr<Chunk> VoxelEngine::get_chunk_cached(const glm::ivec3 &pos)
@@ -973,19 +1082,25 @@ UPtr<Chunk> VoxelEngine::get_chunk_cached(const glm::ivec3 &pos)
 void VoxelEngine::release_chunk(UPtr<Chunk> chunk)
 {
     assert(chunk);
+    if (chunk->mesh_)
+    {
+        release_mesh(*chunk);
+    }
     chunks_pool_.push_back(std::move(chunk));
 }
 
 
-void VoxelEngine::queue_generate_chunk(UPtr<Chunk> chunk)
+void VoxelEngine::queue_generate_chunk(UPtr<Chunk> chunk, int distance2)
 {
     SCOPED_FUNC_PROFILER;
 
     struct Job : tbb::Job
     {
     public:
-        explicit Job(UPtr<Chunk> chunk, VoxelEngine &v)
+        explicit Job(UPtr<Chunk> chunk, unsigned int seed, int cave_lattice_step, VoxelEngine &v)
             : v_(v)
+            , seed_(seed)
+            , cave_lattice_step_(cave_lattice_step)
             , chunk_(std::move(chunk))
         {
             assert(chunk_);
@@ -995,7 +1110,7 @@ void VoxelEngine::queue_generate_chunk(UPtr<Chunk> chunk)
         {
             if (!isCanceled())
             {
-                v_.generate_chunk_threadsafe(*chunk_);
+                generate_chunk_threadsafe(*chunk_, seed_, cave_lattice_step_);
                 generated_ = true;
             }
         }
@@ -1007,176 +1122,118 @@ void VoxelEngine::queue_generate_chunk(UPtr<Chunk> chunk)
     private:
         bool generated_ = false;
         VoxelEngine &v_;
+        unsigned int seed_;
+        int cave_lattice_step_;
         UPtr<Chunk> chunk_;
     };
 
     const glm::ivec3 pos = chunk->getPosition();
 
-    assert(!is_enqued_for_generation(pos.x, pos.z));
-    UPtr<Job> job = makeU<Job>(std::move(chunk), *this);
-    enqueued_chunks_.emplace_back(pos.x, pos.z, job->getCancelToken());
+    // Queued since the load request
+    assert(chunks_map_.getChunkState({pos.x, pos.z}) == ChunksMap::ChunkState::Queued);
+    const int cave_lattice_step = cave_interpolation_ ? cave_lattice_step_ : 1;
+    UPtr<Job> job = makeU<Job>(std::move(chunk), seed_, cave_lattice_step, *this);
+    job->setPriority(tbb::JobPriority::Normal, distance2);
+    enqueued_chunks_.emplace_back(pos.x, pos.z, job->getHandle());
     eng.queue->enqueueJob(std::move(job));
 }
 
-void VoxelEngine::generate_chunk_threadsafe(Chunk &chunk) const
+void VoxelEngine::queue_build_mesh(const Chunk &chunk, const ExtendedNeighbourChunks &neighbours,
+    int distance2)
 {
-    using namespace math;
-
     SCOPED_FUNC_PROFILER;
 
-    constexpr float BASE_FREQ = 0.002f;
-
-    constexpr int MIN = 40;
-    constexpr int HEIGHT = 180;
-    constexpr int MAX = MIN + HEIGHT;
-
-    constexpr int SNOW_OFFSET = MAX - 20;
-    constexpr int SNOW_APLITUDE = 15;
-
-    constexpr int HEIGHT_DISPLACE_AMPLITUDE = 120;
-
-    static_assert(MIN < MAX && MAX < Chunk::CHUNK_HEIGHT && SNOW_OFFSET < Chunk::CHUNK_HEIGHT);
-
-    const glm::ivec2 chunk_pos_i = chunk.getBlocksOffset();
-    const glm::vec2 chunk_pos = glm::vec2(chunk_pos_i);
-    const glm::vec2 chunk_end = glm::vec2(chunk.getBlocksEndOffset());
-
-    // Snow height map
-    noise::module::Billow base_snow;
-    base_snow.SetFrequency(BASE_FREQ * 3);
-    base_snow.SetPersistence(0.7);
-
-    noise::module::MapToMinMax snow_final_blocks;
-    snow_final_blocks.SetSourceModule(0, base_snow);
-    snow_final_blocks.SetMinAndHeight(SNOW_OFFSET, SNOW_APLITUDE);
-
-    noise::utils::NoiseMap snow_map_;
-    noise::utils::NoiseMapBuilderPlane snow_map_builder_;
-    snow_map_builder_.SetSourceModule(snow_final_blocks);
-    snow_map_builder_.SetDestNoiseMap(snow_map_);
-    snow_map_builder_.SetDestSize(16, 16);
-    snow_map_builder_.SetBounds(chunk_pos.x, chunk_end.x, chunk_pos.y, chunk_end.y);
-    snow_map_builder_.Build();
-
-    // Height map
-    noise::module::RidgedMulti mountain;
-    mountain.SetFrequency(BASE_FREQ);
-
-    noise::module::Billow base_flat;
-    base_flat.SetFrequency(BASE_FREQ * 2.2);
-
-    noise::module::ScaleBias flat;
-    flat.SetSourceModule(0, base_flat);
-    flat.SetScale(0.095);
-    flat.SetBias(-0.95);
-
-    noise::module::Perlin type;
-    type.SetFrequency(BASE_FREQ * 0.8);
-    type.SetPersistence(0.4);
-
-    noise::module::Select selector;
-    selector.SetSourceModule(0, flat);
-    selector.SetSourceModule(1, mountain);
-    selector.SetControlModule(type);
-    selector.SetBounds(0.4, 1000);
-    selector.SetEdgeFalloff(0.1);
-
-    noise::module::Turbulence turbulence;
-    turbulence.SetSourceModule(0, selector);
-    turbulence.SetFrequency(BASE_FREQ * 4);
-    turbulence.SetPower(4);
-
-    noise::module::MapToMinMax non_displacement_height_blocks;
-    non_displacement_height_blocks.SetSourceModule(0, turbulence);
-    non_displacement_height_blocks.SetMinAndHeight(MIN, HEIGHT);
-
-    noise::module::Perlin height_displace_perlin;
-    height_displace_perlin.SetFrequency(BASE_FREQ * 0.05);
-    height_displace_perlin.SetOctaveCount(5);
-    height_displace_perlin.SetPersistence(0.7);
-
-    noise::module::MapToMinMax height_displace_blocks;
-    height_displace_blocks.SetSourceModule(0, height_displace_perlin);
-    height_displace_blocks.SetMinAndHeight(0, HEIGHT_DISPLACE_AMPLITUDE);
-
-    noise::module::Add height_final_blocks;
-    height_final_blocks.SetSourceModule(0, non_displacement_height_blocks);
-    height_final_blocks.SetSourceModule(1, height_displace_blocks);
-
-    noise::utils::NoiseMap height_map_;
-    noise::utils::NoiseMapBuilderPlane height_map_builder_;
-    height_map_builder_.SetSourceModule(height_final_blocks);
-    height_map_builder_.SetDestNoiseMap(height_map_);
-    height_map_builder_.SetDestSize(16, 16);
-    height_map_builder_.SetBounds(chunk_pos.x, chunk_end.x, chunk_pos.y, chunk_end.y);
-    height_map_builder_.Build();
-
-    // Caves
-    noise::module::RidgedMulti cave_base;
-    cave_base.SetLacunarity(0.5);
-    cave_base.SetFrequency(BASE_FREQ * 4);
-    cave_base.SetOctaveCount(4);
-
-    noise::module::Turbulence cave;
-    cave.SetSourceModule(0, cave_base);
-    cave.SetFrequency(BASE_FREQ * 3);
-    cave.SetPower(20);
-
-    int block_index = -1;
-    chunk.need_rebuild_mesh_ = true;
-    for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+    struct Job : tbb::Job
     {
-        const double y_glob = (double)y;
-        for (int z = 0; z < Chunk::CHUNK_WIDTH; ++z)
+    public:
+        explicit Job(UPtr<ChunkMeshSnapshot> snapshot, UPtr<ChunkMeshData> data,
+            ChunkMeshGenerator::Mode mode, VoxelEngine &v)
+            : v_(v)
+            , mode_(mode)
+            , snapshot_(std::move(snapshot))
+            , data_(std::move(data))
         {
-            const double z_glob = (double)z + chunk_pos.y;
-            for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
-            {
-                const double x_glob = (double)x + chunk_pos.x;
-                ++block_index;
-                BlockInfo &block = chunk.blocks_[block_index];
-                const int height = (int)height_map_.GetValue(x, z);
-                const int diff = y - height;
-
-                if (diff <= 0)
-                {
-                    const double cave_value = cave.GetValue(x_glob, y_glob, z_glob);
-                    // if (cave_value < -0.6 && cave_value > -0.8)
-                    // if (cave_value > 0.1 && cave_value < 0.7)
-                    if (cave_value > 20)
-                    {
-                        block = BlockInfo(BasicBlocks::AIR);
-                        continue;
-                    }
-                }
+            assert(snapshot_ && data_);
+        }
 
-                if (diff > 0)
-                {
-                    block = BlockInfo(BasicBlocks::AIR);
-                }
-                else
-                {
-                    const int snow_pos = (int)snow_map_.GetValue(x, z);
-                    if (y > snow_pos)
-                    {
-                        block = BlockInfo(BasicBlocks::SNOW);
-                    }
-                    else if (diff == 0)
-                    {
-                        block = BlockInfo(BasicBlocks::GRASS);
-                    }
-                    else if (diff > -4)
-                    {
-                        block = BlockInfo(BasicBlocks::DIRT);
-                    }
-                    else
-                    {
-                        block = BlockInfo(BasicBlocks::STONE);
-                    }
-                }
+        void execute() override
+        {
+            if (!isCanceled())
+            {
+                // The generator has big temporary buffers, reuse them for all jobs of the thread
+                static thread_local ChunkMeshGenerator generator;
+                generator.setMode(mode_);
+                generator.buildMesh(*snapshot_, *data_);
+                built_ = true;
+            }
+        }
+        void finishMainThread() override
+        {
+            ChunkMesh *mesh = v_.finish_build_mesh(snapshot_->getPosition(), built_);
+            if (mesh)
+            {
+                SCOPED_PROFILER("upload mesh");
+                mesh->upload(*data_);
             }
+            v_.release_mesh_snapshot(std::move(snapshot_));
+            v_.release_mesh_data(std::move(data_));
         }
+
+    private:
+        bool built_ = false;
+        VoxelEngine &v_;
+        ChunkMeshGenerator::Mode mode_;
+        UPtr<ChunkMeshSnapshot> snapshot_;
+        UPtr<ChunkMeshData> data_;
+    };
+
+    const glm::ivec3 pos = chunk.getPosition();
+    assert(!is_enqueued_for_meshing(pos.x, pos.z));
+
+    UPtr<ChunkMeshSnapshot> snapshot = get_mesh_snapshot_cached();
+    snapshot->init(chunk, neighbours, *registry_);
+
+    const ChunkMeshGenerator::Mode mode = greedy_meshing_ ? ChunkMeshGenerator::Mode::Greedy
+                                                          : ChunkMeshGenerator::Mode::Naive;
+    UPtr<Job> job = makeU<Job>(std::move(snapshot), get_mesh_data_cached(), mode, *this);
+    // Meshes of the generated chunks are visible sooner, build them before generating more
+    job->setPriority(tbb::JobPriority::High, distance2);
+    chunks_map_.setMeshing({pos.x, pos.z}, true);
+    enqueued_meshes_.emplace_back(pos.x, pos.z, job->getHandle());
+    eng.queue->enqueueJob(std::move(job));
+}
+
+ChunkMesh *VoxelEngine::finish_build_mesh(const glm::ivec3 &pos, bool built)
+{
+    assert(is_enqueued_for_meshing(pos.x, pos.z));
+    const glm::ivec2 pos_xz{pos.x, pos.z};
+    Alg::removeOneIf(enqueued_meshes_, [&](const EnqueuedChunk &c) { return c.pos == pos_xz; });
+    chunks_map_.setMeshing(pos_xz, false);
+
+    if (!built)
+    {
+        return nullptr;
     }
+    // The mesh could be unloaded while the job was running
+    Chunk *chunk = get_chunk_at_pos(pos.x, pos.z);
+    if (!chunk || !chunk->mesh_)
+    {
+        return nullptr;
+    }
+    return chunk->mesh_;
+}
+
+void VoxelEngine::generate_chunk_threadsafe(Chunk &chunk, unsigned int seed,
+    int cave_lattice_step)
+{
+    SCOPED_FUNC_PROFILER;
+
+    // Building the noise modules is expensive, reuse them for all chunks of the thread
+    TerrainGenerator &generator = TerrainGenerator::getThreadGenerator(seed);
+    generator.setCaveLatticeStep(cave_lattice_step);
+
+    chunk.need_rebuild_mesh_ = true;
+    generator.generate(chunk);
 }
 
 void VoxelEngine::finish_generate_chunk(UPtr<Chunk> chunk, bool generated)
@@ -1187,22 +1244,67 @@ void VoxelEngine::finish_generate_chunk(UPtr<Chunk> chunk, bool generated)
     assert(is_enqued_for_generation(x, z));
     glm::ivec2 pos{x, z};
     Alg::removeOneIf(enqueued_chunks_, [&](const EnqueuedChunk &c) { return c.pos == pos; });
-    assert(!is_enqued_for_generation(x, z));
     if (generated)
     {
+        chunks_map_.setChunkState(pos, ChunksMap::ChunkState::Generated);
         generated_chunks_.push_back(std::move(chunk));
     }
     else
     {
+        chunks_map_.setChunkState(pos, ChunksMap::ChunkState::None);
         canceled_chunks_.push_back(std::move(chunk));
     }
 }
 
 void VoxelEngine::on_chunk_unloaded_from_map(UPtr<Chunk> chunk)
 {
+    save_chunk(*chunk);
     release_chunk(std::move(chunk));
 }
 
+void VoxelEngine::create_storage()
+{
+    const std::string directory = eng.fs->toAbsolutePath("saves/") + std::to_string(seed_);
+    storage_ = std::make_shared<RegionStorage>(directory, registry_->getNumBlocks());
+}
+
+void VoxelEngine::save_chunk(Chunk &chunk)
+{
+    if (!chunk.modified_ || !io_)
+    {
+        return;
+    }
+    io_->enqueueSave(storage_, chunk);
+    chunk.modified_ = false;
+}
+
+void VoxelEngine::queue_load_chunk(UPtr<Chunk> chunk)
+{
+    const glm::ivec3 pos = chunk->getPosition();
+    assert(chunks_map_.getChunkState({pos.x, pos.z}) == ChunksMap::ChunkState::None);
+    chunks_map_.setChunkState({pos.x, pos.z}, ChunksMap::ChunkState::Queued);
+    io_->enqueueLoad(storage_, std::move(chunk));
+}
+
+void VoxelEngine::update_io_stats()
+{
+    const double time = eng.time->getTime();
+    const double delta = time - io_stats_.time;
+    if (delta >= IO_STATS_PERIOD_SEC)
+    {
+        const uint64_t bytes_read = io_->getNumBytesRead();
+        const uint64_t bytes_written = io_->getNumBytesWritten();
+        io_stats_.read_bytes_per_sec = (double)(bytes_read - io_stats_.bytes_read) / delta;
+        io_stats_.written_bytes_per_sec = (double)(bytes_written - io_stats_.bytes_written) / delta;
+        io_stats_.bytes_read = bytes_read;
+        io_stats_.bytes_written = bytes_written;
+        io_stats_.time = time;
+    }
+    eng.stat.setChunkIO(io_->getQueueDepth(), io_stats_.read_bytes_per_sec,
+        io_stats_.written_bytes_per_sec);
+    PROFILER_COUNTER("Chunk I/O queue", eng.stat.getChunkIOQueueDepth());
+}
+
 Chunk *VoxelEngine::get_chunk_at_pos(int x, int z) const
 {
     return chunks_map_.getChunk({x, z});
@@ -1275,5 +1377,6 @@ const std::vector<glm::ivec2> &VoxelEngine::OffsetsCache::getOffsets(int radius)
     Alg::sort(values, [](glm::ivec2 lhs, glm::ivec2 rhs) {
         return lhs.x * lhs.x + lhs.y * lhs.y < rhs.x * rhs.x + rhs.y * rhs.y;
     });
+    this->radius = radius;
     return values;
 }
@@ -18,7 +18,8 @@
 
 
 class Material;
-struct ChunkMesh;
+class ChunkMesh;
+class ChunkMeshData;
 struct GlobalLight;
 struct NeighbourChunks;
 struct BlockDescription;
@@ -27,6 +28,10 @@ class ShaderSource;
 class Shader;
 class VertexArrayObject;
 class BlocksRegistry;
+class ChunkMeshGenerator;
+struct ChunkMeshSnapshot;
+class RegionStorage;
+class ChunkIO;
 
 class VoxelEngine
 {
@@ -39,6 +44,17 @@ public:
     void setAmbientOcclusionEnabled(bool enabled);
     bool isAmbientOcclusionEnabled() const;
 
+    // Merge coplanar faces into bigger quads, all loaded meshes are rebuilt on change
+    void setGreedyMeshingEnabled(bool enabled);
+    bool isGreedyMeshingEnabled() const;
+
+    // Cave noise is sampled on a coarse lattice and interpolated, applied to new chunks only
+    void setCaveInterpolationEnabled(bool enabled) { cave_interpolation_ = enabled; }
+    bool isCaveInterpolationEnabled() const { return cave_interpolation_; }
+    // Power of two <= Chunk::CHUNK_WIDTH
+    void setCaveLatticeStep(int step);
+    int getCaveLatticeStep() const { return cave_lattice_step_; }
+
     void init();
 
     void update(const glm::vec3 &position);
@@ -48,8 +64,12 @@ public:
     BlocksRegistry *getRegistry() const { return registry_.get(); }
 
     unsigned int getSeed() const { return seed_; }
+    // The modified chunks are saved to the storage of the old seed
     void setSeed(unsigned int seed);
 
+    // Write all modified chunks of the map to the storage
+    void saveModifiedChunks();
+
     Material *getEnvironmentMaterial();
 
     static REALENGINE_INLINE glm::ivec3 toBlockPosition(const glm::vec3 &position)
@@ -114,20 +134,37 @@ public:
         const VisitIntersectionCallback &callback) const;
 
 private:
-    void register_blocks();
 
-    UPtr<ChunkMesh> get_mesh_cached();
-    void release_mesh(UPtr<ChunkMesh> mesh);
+    ChunkMesh *get_mesh_cached();
+    // Returns the mesh of the chunk to the pool
+    void release_mesh(Chunk &chunk);
+
+    UPtr<ChunkMeshData> get_mesh_data_cached();
+    void release_mesh_data(UPtr<ChunkMeshData> data);
+
+    UPtr<ChunkMeshSnapshot> get_mesh_snapshot_cached();
+    void release_mesh_snapshot(UPtr<ChunkMeshSnapshot> snapshot);
 
     UPtr<Chunk> get_chunk_cached(const glm::ivec3 &pos);
     void release_chunk(UPtr<Chunk> chunk);
 
-    void queue_generate_chunk(UPtr<Chunk> chunk);
-    void generate_chunk_threadsafe(Chunk &chunk) const;
+    void queue_generate_chunk(UPtr<Chunk> chunk, int distance2);
+    static void generate_chunk_threadsafe(Chunk &chunk, unsigned int seed, int cave_lattice_step);
     void finish_generate_chunk(UPtr<Chunk> chunk, bool generated);
 
+    void queue_build_mesh(const Chunk &chunk, const ExtendedNeighbourChunks &neighbours,
+        int distance2);
+    // Returns the mesh to upload the built vertices to, null if the result isn't needed anymore
+    ChunkMesh *finish_build_mesh(const glm::ivec3 &pos, bool built);
+
     void on_chunk_unloaded_from_map(UPtr<Chunk> chunk);
 
+    void create_storage();
+    void save_chunk(Chunk &chunk);
+    // The chunk is generated if it isn't stored
+    void queue_load_chunk(UPtr<Chunk> chunk);
+    void update_io_stats();
+
     static REALENGINE_INLINE glm::ivec3 pos_to_chunk_pos(const glm::vec3 &pos)
     {
         const auto x = math::floorToCell(std::floor(pos.x), Chunk::CHUNK_WIDTH);
@@ -152,16 +189,17 @@ private:
 
     REALENGINE_INLINE bool is_enqued_for_generation(int x, int z) const
     {
-        const glm::ivec2 pos = glm::ivec2{x, z};
-        return Alg::anyOf(enqueued_chunks_, [&](const EnqueuedChunk &c) { return c.pos == pos; });
+        return chunks_map_.getChunkState({x, z}) == ChunksMap::ChunkState::Queued;
+    }
+
+    REALENGINE_INLINE bool is_enqueued_for_meshing(int x, int z) const
+    {
+        return chunks_map_.isMeshing({x, z});
     }
 
     REALENGINE_INLINE bool is_generated(int x, int z) const
     {
-        return Alg::anyOf(generated_chunks_, [&](const UPtr<Chunk> &c) {
-            const glm::ivec3 pos = c->getPosition();
-            return pos.x == x && pos.z == z;
-        });
+        return chunks_map_.getChunkState({x, z}) == ChunksMap::ChunkState::Generated;
     }
 
     bool has_all_neighbours(Chunk *chunk) const;
@@ -172,27 +210,34 @@ private:
     bool first_update_{true};
 
     unsigned int seed_{0};
-    struct Perlin;
-    UPtr<Perlin> perlin_;
+
+    // Shared with the generation jobs, they can outlive the storage of the old seed
+    std::shared_ptr<RegionStorage> storage_;
+    UPtr<ChunkIO> io_;
 
     glm::ivec3 last_base_chunk_pos_{};
 
-    std::vector<UPtr<ChunkMesh>> meshes_pool_;
+    // All the created meshes, the chunks refer to them
+    std::vector<UPtr<ChunkMesh>> meshes_;
+    std::vector<ChunkMesh *> meshes_pool_;
+    std::vector<UPtr<ChunkMeshData>> mesh_data_pool_;
+    std::vector<UPtr<ChunkMeshSnapshot>> mesh_snapshots_pool_;
     std::vector<UPtr<Chunk>> chunks_pool_;
 
     ChunksMap chunks_map_;
 
     struct EnqueuedChunk
     {
-        EnqueuedChunk(int x, int z, tbb::CancelToken cancel_token)
+        EnqueuedChunk(int x, int z, tbb::JobHandle handle)
             : pos(x, z)
-            , cancel_token(std::move(cancel_token))
+            , handle(handle)
         {}
         glm::ivec2 pos;
-        tbb::CancelToken cancel_token;
+        tbb::JobHandle handle;
     };
 
     std::vector<EnqueuedChunk> enqueued_chunks_;
+    std::vector<EnqueuedChunk> enqueued_meshes_;
 
     std::vector<UPtr<Chunk>> chunks_to_generate_;
 
@@ -205,9 +250,15 @@ private:
 
     UPtr<BlocksRegistry> registry_;
 
+    bool greedy_meshing_{true};
+
+    bool cave_interpolation_{true};
+    int cave_lattice_step_{4};
+
     // TEMPORAY IN FUNCTION
     std::vector<Chunk *> chunks_for_regenerate_;
     std::vector<Chunk *> chunks_for_render_;
+    std::vector<uint8_t> chunks_visible_; // by the index in chunks_map_
 
     int old_num_inited_chunks_{0};
 
@@ -227,4 +278,13 @@ private:
         ShaderSource *shader_source_{};
         Material *material{};
     } env_;
+
+    struct
+    {
+        double time{0.0};
+        uint64_t bytes_read{0};
+        uint64_t bytes_written{0};
+        double read_bytes_per_sec{0.0};
+        double written_bytes_per_sec{0.0};
+    } io_stats_;
 };
@@ -0,0 +1,874 @@
+#include "BatchNoise.h"
+
+#include "Base.h"
+#include "MapToMinMax.h"
+
+#include <noise/noise.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX2__)
+    #define NOISE_SIMD_AVX2
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define NOISE_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace noise
+{
+// Defined in noisegen.cpp
+extern double g_randomVectors[256 * 4];
+} // namespace noise
+
+using namespace noise;
+using namespace noise::module;
+using noise::batch::MAX_POINTS;
+
+namespace
+{
+
+// Same as in noisegen.cpp (NOISE_VERSION 2)
+constexpr int X_NOISE_GEN = 1619;
+constexpr int Y_NOISE_GEN = 31337;
+constexpr int Z_NOISE_GEN = 6971;
+constexpr int SEED_NOISE_GEN = 1013;
+constexpr int SHIFT_NOISE_GEN = 8;
+
+const float *get_gradients()
+{
+    struct Table
+    {
+        Table()
+        {
+            for (int i = 0; i < 256 * 4; ++i)
+            {
+                values[i] = (float)g_randomVectors[i];
+            }
+        }
+        float values[256 * 4];
+    };
+    static const Table table;
+    return table.values;
+}
+
+REALENGINE_INLINE int wrap_mul(int a, int b)
+{
+    return (int)((uint32_t)a * (uint32_t)b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Lanes
+
+#if defined(NOISE_SIMD_AVX2)
+
+constexpr int LANES = 8;
+using VFloat = __m256;
+using VInt = __m256i;
+
+REALENGINE_INLINE VFloat load(const float *p)
+{
+    return _mm256_loadu_ps(p);
+}
+REALENGINE_INLINE VInt loadi(const int *p)
+{
+    return _mm256_loadu_si256((const VInt *)p);
+}
+REALENGINE_INLINE void store(float *p, VFloat v)
+{
+    _mm256_storeu_ps(p, v);
+}
+REALENGINE_INLINE VFloat set1(float v)
+{
+    return _mm256_set1_ps(v);
+}
+REALENGINE_INLINE VInt set1i(int v)
+{
+    return _mm256_set1_epi32(v);
+}
+REALENGINE_INLINE VFloat add(VFloat a, VFloat b)
+{
+    return _mm256_add_ps(a, b);
+}
+REALENGINE_INLINE VFloat sub(VFloat a, VFloat b)
+{
+    return _mm256_sub_ps(a, b);
+}
+REALENGINE_INLINE VFloat mul(VFloat a, VFloat b)
+{
+    return _mm256_mul_ps(a, b);
+}
+REALENGINE_INLINE VFloat div(VFloat a, VFloat b)
+{
+    return _mm256_div_ps(a, b);
+}
+REALENGINE_INLINE VFloat min(VFloat a, VFloat b)
+{
+    return _mm256_min_ps(a, b);
+}
+REALENGINE_INLINE VFloat max(VFloat a, VFloat b)
+{
+    return _mm256_max_ps(a, b);
+}
+REALENGINE_INLINE VFloat abs(VFloat a)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+}
+REALENGINE_INLINE VFloat less(VFloat a, VFloat b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+REALENGINE_INLINE VFloat greater(VFloat a, VFloat b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+REALENGINE_INLINE VFloat mask_or(VFloat a, VFloat b)
+{
+    return _mm256_or_ps(a, b);
+}
+// mask ? a : b
+REALENGINE_INLINE VFloat select(VFloat mask, VFloat a, VFloat b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+REALENGINE_INLINE VInt addi(VInt a, VInt b)
+{
+    return _mm256_add_epi32(a, b);
+}
+REALENGINE_INLINE VInt muli(VInt a, VInt b)
+{
+    return _mm256_mullo_epi32(a, b);
+}
+REALENGINE_INLINE VInt xori(VInt a, VInt b)
+{
+    return _mm256_xor_si256(a, b);
+}
+REALENGINE_INLINE VInt andi(VInt a, VInt b)
+{
+    return _mm256_and_si256(a, b);
+}
+template<int N>
+REALENGINE_INLINE VInt srli(VInt a)
+{
+    return _mm256_srli_epi32(a, N);
+}
+template<int N>
+REALENGINE_INLINE VInt slli(VInt a)
+{
+    return _mm256_slli_epi32(a, N);
+}
+REALENGINE_INLINE VFloat gather(const float *table, VInt index)
+{
+    return _mm256_i32gather_ps(table, index, 4);
+}
+
+#elif defined(NOISE_SIMD_SSE2)
+
+constexpr int LANES = 4;
+using VFloat = __m128;
+using VInt = __m128i;
+
+REALENGINE_INLINE VFloat load(const float *p)
+{
+    return _mm_loadu_ps(p);
+}
+REALENGINE_INLINE VInt loadi(const int *p)
+{
+    return _mm_loadu_si128((const VInt *)p);
+}
+REALENGINE_INLINE void store(float *p, VFloat v)
+{
+    _mm_storeu_ps(p, v);
+}
+REALENGINE_INLINE VFloat set1(float v)
+{
+    return _mm_set1_ps(v);
+}
+REALENGINE_INLINE VInt set1i(int v)
+{
+    return _mm_set1_epi32(v);
+}
+REALENGINE_INLINE VFloat add(VFloat a, VFloat b)
+{
+    return _mm_add_ps(a, b);
+}
+REALENGINE_INLINE VFloat sub(VFloat a, VFloat b)
+{
+    return _mm_sub_ps(a, b);
+}
+REALENGINE_INLINE VFloat mul(VFloat a, VFloat b)
+{
+    return _mm_mul_ps(a, b);
+}
+REALENGINE_INLINE VFloat div(VFloat a, VFloat b)
+{
+    return _mm_div_ps(a, b);
+}
+REALENGINE_INLINE VFloat min(VFloat a, VFloat b)
+{
+    return _mm_min_ps(a, b);
+}
+REALENGINE_INLINE VFloat max(VFloat a, VFloat b)
+{
+    return _mm_max_ps(a, b);
+}
+REALENGINE_INLINE VFloat abs(VFloat a)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+REALENGINE_INLINE VFloat less(VFloat a, VFloat b)
+{
+    return _mm_cmplt_ps(a, b);
+}
+REALENGINE_INLINE VFloat greater(VFloat a, VFloat b)
+{
+    return _mm_cmpgt_ps(a, b);
+}
+REALENGINE_INLINE VFloat mask_or(VFloat a, VFloat b)
+{
+    return _mm_or_ps(a, b);
+}
+// mask ? a : b
+REALENGINE_INLINE VFloat select(VFloat mask, VFloat a, VFloat b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+REALENGINE_INLINE VInt addi(VInt a, VInt b)
+{
+    return _mm_add_epi32(a, b);
+}
+// No _mm_mullo_epi32 in SSE2
+REALENGINE_INLINE VInt muli(VInt a, VInt b)
+{
+    const VInt even = _mm_mul_epu32(a, b);
+    const VInt odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+REALENGINE_INLINE VInt xori(VInt a, VInt b)
+{
+    return _mm_xor_si128(a, b);
+}
+REALENGINE_INLINE VInt andi(VInt a, VInt b)
+{
+    return _mm_and_si128(a, b);
+}
+template<int N>
+REALENGINE_INLINE VInt srli(VInt a)
+{
+    return _mm_srli_epi32(a, N);
+}
+template<int N>
+REALENGINE_INLINE VInt slli(VInt a)
+{
+    return _mm_slli_epi32(a, N);
+}
+REALENGINE_INLINE VFloat gather(const float *table, VInt index)
+{
+    alignas(16) int i[4];
+    _mm_store_si128((VInt *)i, index);
+    return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+}
+
+#else
+
+constexpr int LANES = 1;
+using VFloat = float;
+using VInt = int;
+
+REALENGINE_INLINE VFloat load(const float *p)
+{
+    return *p;
+}
+REALENGINE_INLINE VInt loadi(const int *p)
+{
+    return *p;
+}
+REALENGINE_INLINE void store(float *p, VFloat v)
+{
+    *p = v;
+}
+REALENGINE_INLINE VFloat set1(float v)
+{
+    return v;
+}
+REALENGINE_INLINE VInt set1i(int v)
+{
+    return v;
+}
+REALENGINE_INLINE VFloat add(VFloat a, VFloat b)
+{
+    return a + b;
+}
+REALENGINE_INLINE VFloat sub(VFloat a, VFloat b)
+{
+    return a - b;
+}
+REALENGINE_INLINE VFloat mul(VFloat a, VFloat b)
+{
+    return a * b;
+}
+REALENGINE_INLINE VFloat div(VFloat a, VFloat b)
+{
+    return a / b;
+}
+REALENGINE_INLINE VFloat min(VFloat a, VFloat b)
+{
+    return std::min(a, b);
+}
+REALENGINE_INLINE VFloat max(VFloat a, VFloat b)
+{
+    return std::max(a, b);
+}
+REALENGINE_INLINE VFloat abs(VFloat a)
+{
+    return std::fabs(a);
+}
+// Masks are 0/1 floats
+REALENGINE_INLINE VFloat less(VFloat a, VFloat b)
+{
+    return a < b ? 1.0f : 0.0f;
+}
+REALENGINE_INLINE VFloat greater(VFloat a, VFloat b)
+{
+    return a > b ? 1.0f : 0.0f;
+}
+REALENGINE_INLINE VFloat mask_or(VFloat a, VFloat b)
+{
+    return (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f;
+}
+// mask ? a : b
+REALENGINE_INLINE VFloat select(VFloat mask, VFloat a, VFloat b)
+{
+    return mask != 0.0f ? a : b;
+}
+REALENGINE_INLINE VInt addi(VInt a, VInt b)
+{
+    return (int)((uint32_t)a + (uint32_t)b);
+}
+REALENGINE_INLINE VInt muli(VInt a, VInt b)
+{
+    return wrap_mul(a, b);
+}
+REALENGINE_INLINE VInt xori(VInt a, VInt b)
+{
+    return a ^ b;
+}
+REALENGINE_INLINE VInt andi(VInt a, VInt b)
+{
+    return a & b;
+}
+template<int N>
+REALENGINE_INLINE VInt srli(VInt a)
+{
+    return (int)((uint32_t)a >> N);
+}
+template<int N>
+REALENGINE_INLINE VInt slli(VInt a)
+{
+    return (int)((uint32_t)a << N);
+}
+REALENGINE_INLINE VFloat gather(const float *table, VInt index)
+{
+    return table[index];
+}
+
+#endif
+
+REALENGINE_INLINE int round_up_to_lanes(int count)
+{
+    return (count + LANES - 1) / LANES * LANES;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Coherent noise, same as noise::GradientCoherentNoise3D
+
+REALENGINE_INLINE VFloat lerp(VFloat n0, VFloat n1, VFloat a)
+{
+    return add(n0, mul(a, sub(n1, n0)));
+}
+
+REALENGINE_INLINE VFloat s_curve3(VFloat a)
+{
+    return mul(mul(a, a), sub(set1(3.0f), mul(set1(2.0f), a)));
+}
+
+REALENGINE_INLINE VFloat s_curve(VFloat a, NoiseQuality quality)
+{
+    switch (quality)
+    {
+    case QUALITY_FAST: return a;
+    case QUALITY_STD: return s_curve3(a);
+    case QUALITY_BEST:
+    {
+        const VFloat a3 = mul(mul(a, a), a);
+        return mul(a3, add(mul(a, sub(mul(a, set1(6.0f)), set1(15.0f))), set1(10.0f)));
+    }
+    }
+    return a;
+}
+
+// hash = X_NOISE_GEN * ix + Y_NOISE_GEN * iy + Z_NOISE_GEN * iz + SEED_NOISE_GEN * seed
+REALENGINE_INLINE VFloat gradient_noise(VFloat px, VFloat py, VFloat pz, VInt hash,
+    const float *gradients)
+{
+    VInt index = xori(hash, srli<SHIFT_NOISE_GEN>(hash));
+    index = slli<2>(andi(index, set1i(0xff)));
+    const VFloat gx = gather(gradients, index);
+    const VFloat gy = gather(gradients + 1, index);
+    const VFloat gz = gather(gradients + 2, index);
+    return mul(add(add(mul(gx, px), mul(gy, py)), mul(gz, pz)), set1(2.12f));
+}
+
+// Lattice cells of the points and the offsets in the cells. The coordinates are split in double, so
+// the float offsets don't lose the precision far from the origin
+struct LatticePoints
+{
+    int cell[3][MAX_POINTS];
+    float offset[3][MAX_POINTS];
+};
+
+// Scale the coordinates and split them as MakeInt32Range and noise::GradientCoherentNoise3D do
+void split_points(const double *const coords[3], double scale, int n, LatticePoints &points)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const double *coord = coords[axis];
+        int *cell = points.cell[axis];
+        float *offset = points.offset[axis];
+        for (int i = 0; i < n; ++i)
+        {
+            const double value = MakeInt32Range(coord[i] * scale);
+            const int value0 = value > 0.0 ? (int)value : (int)value - 1;
+            cell[i] = value0;
+            offset[i] = (float)(value - (double)value0);
+        }
+    }
+}
+
+REALENGINE_INLINE VFloat gradient_coherent_noise(const LatticePoints &points, int i, int seed,
+    NoiseQuality quality, const float *gradients)
+{
+    const VInt ix0 = loadi(points.cell[0] + i);
+    const VInt iy0 = loadi(points.cell[1] + i);
+    const VInt iz0 = loadi(points.cell[2] + i);
+
+    const VFloat one = set1(1.0f);
+    const VFloat px0 = load(points.offset[0] + i);
+    const VFloat py0 = load(points.offset[1] + i);
+    const VFloat pz0 = load(points.offset[2] + i);
+    const VFloat px1 = sub(px0, one);
+    const VFloat py1 = sub(py0, one);
+    const VFloat pz1 = sub(pz0, one);
+
+    const VFloat xs = s_curve(px0, quality);
+    const VFloat ys = s_curve(py0, quality);
+    const VFloat zs = s_curve(pz0, quality);
+
+    const VInt hx0 = muli(ix0, set1i(X_NOISE_GEN));
+    const VInt hx1 = addi(hx0, set1i(X_NOISE_GEN));
+    const VInt hy0 = muli(iy0, set1i(Y_NOISE_GEN));
+    const VInt hy1 = addi(hy0, set1i(Y_NOISE_GEN));
+    const VInt hz0 = addi(muli(iz0, set1i(Z_NOISE_GEN)), set1i(wrap_mul(SEED_NOISE_GEN, seed)));
+    const VInt hz1 = addi(hz0, set1i(Z_NOISE_GEN));
+
+    const VInt h00 = addi(hy0, hz0);
+    const VInt h10 = addi(hy1, hz0);
+    const VInt h01 = addi(hy0, hz1);
+    const VInt h11 = addi(hy1, hz1);
+
+    VFloat n0 = gradient_noise(px0, py0, pz0, addi(hx0, h00), gradients);
+    VFloat n1 = gradient_noise(px1, py0, pz0, addi(hx1, h00), gradients);
+    VFloat ix0_v = lerp(n0, n1, xs);
+    n0 = gradient_noise(px0, py1, pz0, addi(hx0, h10), gradients);
+    n1 = gradient_noise(px1, py1, pz0, addi(hx1, h10), gradients);
+    VFloat ix1_v = lerp(n0, n1, xs);
+    const VFloat iy0_v = lerp(ix0_v, ix1_v, ys);
+
+    n0 = gradient_noise(px0, py0, pz1, addi(hx0, h01), gradients);
+    n1 = gradient_noise(px1, py0, pz1, addi(hx1, h01), gradients);
+    ix0_v = lerp(n0, n1, xs);
+    n0 = gradient_noise(px0, py1, pz1, addi(hx0, h11), gradients);
+    n1 = gradient_noise(px1, py1, pz1, addi(hx1, h11), gradients);
+    ix1_v = lerp(n0, n1, xs);
+    const VFloat iy1_v = lerp(ix0_v, ix1_v, ys);
+
+    return lerp(iy0_v, iy1_v, zs);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Modules. All the arrays have n elements, n is a multiple of LANES and <= MAX_POINTS
+
+void eval(const Module &module, const double *x, const double *y, const double *z, int n,
+    float *out);
+
+struct FractalParams
+{
+    double frequency;
+    double lacunarity;
+    float persistence;
+    int octaves;
+    int seed;
+    NoiseQuality quality;
+};
+
+void eval_perlin(const FractalParams &p, const double *x, const double *y, const double *z,
+    int n, float *out)
+{
+    const float *gradients = get_gradients();
+    const double *coords[3] = {x, y, z};
+    LatticePoints points;
+
+    std::fill_n(out, n, 0.0f);
+    double scale = p.frequency;
+    float persistence = 1.0f;
+    for (int octave = 0; octave < p.octaves; ++octave)
+    {
+        split_points(coords, scale, n, points);
+        const VFloat amplitude = set1(persistence);
+        for (int i = 0; i < n; i += LANES)
+        {
+            const VFloat signal = gradient_coherent_noise(points, i, p.seed + octave, p.quality,
+                gradients);
+            store(out + i, add(load(out + i), mul(signal, amplitude)));
+        }
+        scale *= p.lacunarity;
+        persistence *= p.persistence;
+    }
+}
+
+void eval_billow(const Billow &m, const double *x, const double *y, const double *z, int n,
+    float *out)
+{
+    const float *gradients = get_gradients();
+    const double *coords[3] = {x, y, z};
+    const float persistence_mul = (float)m.GetPersistence();
+    const int octaves = m.GetOctaveCount();
+    const int seed = m.GetSeed();
+    const NoiseQuality quality = m.GetNoiseQuality();
+    LatticePoints points;
+
+    std::fill_n(out, n, 0.5f);
+    double scale = m.GetFrequency();
+    float persistence = 1.0f;
+    for (int octave = 0; octave < octaves; ++octave)
+    {
+        split_points(coords, scale, n, points);
+        const VFloat amplitude = set1(persistence);
+        for (int i = 0; i < n; i += LANES)
+        {
+            VFloat signal = gradient_coherent_noise(points, i, seed + octave, quality, gradients);
+            signal = sub(mul(set1(2.0f), abs(signal)), set1(1.0f));
+            store(out + i, add(load(out + i), mul(signal, amplitude)));
+        }
+        scale *= m.GetLacunarity();
+        persistence *= persistence_mul;
+    }
+}
+
+void eval_ridged_multi(const RidgedMulti &m, const double *x, const double *y, const double *z,
+    int n, float *out)
+{
+    const float *gradients = get_gradients();
+    const double *coords[3] = {x, y, z};
+    const int octaves = m.GetOctaveCount();
+    const int seed = m.GetSeed();
+    const NoiseQuality quality = m.GetNoiseQuality();
+    LatticePoints points;
+
+    // RidgedMulti::CalcSpectralWeights with h = 1
+    float spectral_weights[RIDGED_MAX_OCTAVE];
+    double octave_frequency = 1.0;
+    for (int i = 0; i < RIDGED_MAX_OCTAVE; ++i)
+    {
+        spectral_weights[i] = (float)(1.0 / octave_frequency);
+        octave_frequency *= m.GetLacunarity();
+    }
+
+    float weights[MAX_POINTS];
+    std::fill_n(weights, n, 1.0f);
+    std::fill_n(out, n, 0.0f);
+
+    const VFloat offset = set1(1.0f);
+    const VFloat gain = set1(2.0f);
+    double scale = m.GetFrequency();
+    for (int octave = 0; octave < octaves; ++octave)
+    {
+        split_points(coords, scale, n, points);
+        const int octave_seed = (seed + octave) & 0x7fffffff;
+        const VFloat spectral_weight = set1(spectral_weights[octave]);
+        for (int i = 0; i < n; i += LANES)
+        {
+            VFloat signal = gradient_coherent_noise(points, i, octave_seed, quality, gradients);
+            signal = sub(offset, abs(signal));
+            signal = mul(mul(signal, signal), load(weights + i));
+            store(weights + i, min(max(mul(signal, gain), set1(0.0f)), set1(1.0f)));
+            store(out + i, add(load(out + i), mul(signal, spectral_weight)));
+        }
+        scale *= m.GetLacunarity();
+    }
+
+    for (int i = 0; i < n; i += LANES)
+    {
+        store(out + i, sub(mul(load(out + i), set1(1.25f)), set1(1.0f)));
+    }
+}
+
+void eval_scale_bias(const ScaleBias &m, const double *x, const double *y, const double *z,
+    int n, float *out)
+{
+    eval(m.GetSourceModule(0), x, y, z, n, out);
+    const VFloat scale = set1((float)m.GetScale());
+    const VFloat bias = set1((float)m.GetBias());
+    for (int i = 0; i < n; i += LANES)
+    {
+        store(out + i, add(mul(load(out + i), scale), bias));
+    }
+}
+
+void eval_add(const Add &m, const double *x, const double *y, const double *z, int n, float *out)
+{
+    float other[MAX_POINTS];
+    eval(m.GetSourceModule(0), x, y, z, n, out);
+    eval(m.GetSourceModule(1), x, y, z, n, other);
+    for (int i = 0; i < n; i += LANES)
+    {
+        store(out + i, add(load(out + i), load(other + i)));
+    }
+}
+
+// Unlike Select::GetValue both sources are evaluated for all the points
+void eval_select(const Select &m, const double *x, const double *y, const double *z, int n,
+    float *out)
+{
+    float control[MAX_POINTS];
+    float source1[MAX_POINTS];
+    eval(m.GetControlModule(), x, y, z, n, control);
+    eval(m.GetSourceModule(0), x, y, z, n, out);
+    eval(m.GetSourceModule(1), x, y, z, n, source1);
+
+    const float lower = (float)m.GetLowerBound();
+    const float upper = (float)m.GetUpperBound();
+    const float falloff = (float)m.GetEdgeFalloff();
+
+    if (falloff > 0.0f)
+    {
+        // SetEdgeFalloff keeps the falloff <= half of the bounds size, so the lower curve ends
+        // before the upper one starts
+        const VFloat lower_curve = set1(lower - falloff);
+        const VFloat upper_curve = set1(upper - falloff);
+        const VFloat curve_size = set1(2.0f * falloff);
+        const VFloat zero = set1(0.0f);
+        const VFloat one = set1(1.0f);
+        for (int i = 0; i < n; i += LANES)
+        {
+            const VFloat c = load(control + i);
+            const VFloat s0 = load(out + i);
+            const VFloat s1 = load(source1 + i);
+            const VFloat alpha_lower = s_curve3(
+                min(max(div(sub(c, lower_curve), curve_size), zero), one));
+            const VFloat alpha_upper = s_curve3(
+                min(max(div(sub(c, upper_curve), curve_size), zero), one));
+            const VFloat value = select(less(c, upper_curve), lerp(s0, s1, alpha_lower),
+                lerp(s1, s0, alpha_upper));
+            store(out + i, value);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; i += LANES)
+        {
+            const VFloat c = load(control + i);
+            const VFloat outside = mask_or(less(c, set1(lower)), greater(c, set1(upper)));
+            store(out + i, select(outside, load(out + i), load(source1 + i)));
+        }
+    }
+}
+
+void eval_turbulence(const Turbulence &m, const double *x, const double *y, const double *z,
+    int n, float *out)
+{
+    // Same distort modules as the Turbulence creates
+    FractalParams params;
+    params.frequency = m.GetFrequency();
+    params.lacunarity = DEFAULT_PERLIN_LACUNARITY;
+    params.persistence = (float)DEFAULT_PERLIN_PERSISTENCE;
+    params.octaves = m.GetRoughnessCount();
+    params.quality = DEFAULT_PERLIN_QUALITY;
+
+    const double offsets[3][3] = {
+        {12414.0 / 65536.0, 65124.0 / 65536.0, 31337.0 / 65536.0},
+        {26519.0 / 65536.0, 18128.0 / 65536.0, 60493.0 / 65536.0},
+        {53820.0 / 65536.0, 11213.0 / 65536.0, 44845.0 / 65536.0},
+    };
+    const double *coords[3] = {x, y, z};
+
+    double ox[MAX_POINTS];
+    double oy[MAX_POINTS];
+    double oz[MAX_POINTS];
+    float distort[MAX_POINTS];
+    double distorted[3][MAX_POINTS];
+
+    const double power = m.GetPower();
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            ox[i] = x[i] + offsets[axis][0];
+            oy[i] = y[i] + offsets[axis][1];
+            oz[i] = z[i] + offsets[axis][2];
+        }
+
+        params.seed = m.GetSeed() + axis;
+        eval_perlin(params, ox, oy, oz, n, distort);
+
+        const double *coord = coords[axis];
+        for (int i = 0; i < n; ++i)
+        {
+            distorted[axis][i] = coord[i] + (double)distort[i] * power;
+        }
+    }
+
+    eval(m.GetSourceModule(0), distorted[0], distorted[1], distorted[2], n, out);
+}
+
+void eval_scalar(const Module &module, const double *x, const double *y, const double *z, int n,
+    float *out)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        out[i] = (float)module.GetValue(x[i], y[i], z[i]);
+    }
+}
+
+void eval(const Module &module, const double *x, const double *y, const double *z, int n,
+    float *out)
+{
+    assert(n % LANES == 0 && n <= MAX_POINTS);
+
+    if (const auto *m = dynamic_cast<const Perlin *>(&module))
+    {
+        FractalParams params;
+        params.frequency = m->GetFrequency();
+        params.lacunarity = m->GetLacunarity();
+        params.persistence = (float)m->GetPersistence();
+        params.octaves = m->GetOctaveCount();
+        params.seed = m->GetSeed();
+        params.quality = m->GetNoiseQuality();
+        eval_perlin(params, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const Billow *>(&module))
+    {
+        eval_billow(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const RidgedMulti *>(&module))
+    {
+        eval_ridged_multi(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const ScaleBias *>(&module))
+    {
+        eval_scale_bias(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const Add *>(&module))
+    {
+        eval_add(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const Select *>(&module))
+    {
+        eval_select(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const Turbulence *>(&module))
+    {
+        eval_turbulence(*m, x, y, z, n, out);
+    }
+    else if (const auto *m = dynamic_cast<const MapToMinMax *>(&module))
+    {
+        eval(m->GetSourceModule(0), x, y, z, n, out);
+        m->MapValues(out, n);
+    }
+    else
+    {
+        eval_scalar(module, x, y, z, n, out);
+    }
+}
+
+} // namespace
+
+bool noise::batch::IsSimdEnabled()
+{
+    return LANES > 1;
+}
+
+void noise::batch::GetValues(const Module &module, const double *x, const double *y,
+    const double *z, int count, float *out)
+{
+    double bx[MAX_POINTS];
+    double by[MAX_POINTS];
+    double bz[MAX_POINTS];
+    float bout[MAX_POINTS];
+
+    for (int begin = 0; begin < count; begin += MAX_POINTS)
+    {
+        const int num = std::min(count - begin, MAX_POINTS);
+        const int padded = round_up_to_lanes(num);
+
+        std::copy_n(x + begin, num, bx);
+        std::copy_n(y + begin, num, by);
+        std::copy_n(z + begin, num, bz);
+        std::fill(bx + num, bx + padded, bx[num - 1]);
+        std::fill(by + num, by + padded, by[num - 1]);
+        std::fill(bz + num, bz + padded, bz[num - 1]);
+
+        eval(module, bx, by, bz, padded, bout);
+
+        std::copy_n(bout, num, out + begin);
+    }
+}
+
+void noise::batch::BuildPlane(const Module &module, double lower_x, double upper_x,
+    double lower_z, double upper_z, int width, int height, float *out)
+{
+    assert(upper_x > lower_x && upper_z > lower_z && width > 0 && height > 0);
+
+    const double delta_x = (upper_x - lower_x) / (double)width;
+    const double delta_z = (upper_z - lower_z) / (double)height;
+
+    double x[MAX_POINTS];
+    double y[MAX_POINTS];
+    double z[MAX_POINTS];
+    std::fill_n(y, MAX_POINTS, 0.0);
+
+    const int count = width * height;
+    for (int begin = 0; begin < count; begin += MAX_POINTS)
+    {
+        const int num = std::min(count - begin, MAX_POINTS);
+        for (int i = 0; i < num; ++i)
+        {
+            const int index = begin + i;
+            x[i] = lower_x + (index % width) * delta_x;
+            z[i] = lower_z + (index / width) * delta_z;
+        }
+        GetValues(module, x, y, z, num, out + begin);
+    }
+}
+
+double noise::batch::GetMaxError(const Module &module, const double *x, const double *y,
+    const double *z, int count)
+{
+    float values[MAX_POINTS];
+    double max_error = 0.0;
+    for (int begin = 0; begin < count; begin += MAX_POINTS)
+    {
+        const int num = std::min(count - begin, MAX_POINTS);
+        GetValues(module, x + begin, y + begin, z + begin, num, values);
+        for (int i = 0; i < num; ++i)
+        {
+            const int index = begin + i;
+            const double expected = module.GetValue(x[index], y[index], z[index]);
+            max_error = std::max(max_error, std::abs(expected - (double)values[i]));
+        }
+    }
+    return max_error;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <noise/module/modulebase.h>
+
+namespace noise
+{
+
+namespace batch
+{
+
+// Points of one internal batch, bigger inputs are split
+constexpr int MAX_POINTS = 256;
+
+// Whether the points are evaluated with SSE2/AVX2 lanes or one by one
+bool IsSimdEnabled();
+
+// Evaluate the module at the points. Perlin, Billow, RidgedMulti, ScaleBias, Add, Select,
+// Turbulence and MapToMinMax are evaluated in batches, other modules (and any modules under them)
+// fall back to the scalar GetValue. The coordinates are kept in double until each octave splits
+// them into the lattice cells and the float offsets in the cells, so the error doesn't grow with
+// the distance from the origin; the noise values are calculated in floats
+void GetValues(const module::Module &module, const double *x, const double *y, const double *z,
+    int count, float *out);
+
+// Same points as NoiseMapBuilderPlane: width x height values of the y = 0 plane, the upper bounds
+// are exclusive. Values are stored row by row (x is the fastest)
+void BuildPlane(const module::Module &module, double lower_x, double upper_x, double lower_z,
+    double upper_z, int width, int height, float *out);
+
+// Max absolute difference between the batch and the scalar GetValue results
+double GetMaxError(const module::Module &module, const double *x, const double *y,
+    const double *z, int count);
+
+} // namespace batch
+
+} // namespace noise
@@ -1,5 +1,7 @@
 #include "MapToMinMax.h"
 
+#include "BatchNoise.h"
+
 using namespace noise::module;
 
 MapToMinMax::MapToMinMax()
@@ -16,6 +18,24 @@ double MapToMinMax::GetValue(double x, double y, double z) const
     return (value * 0.5 + 0.5) * height_ + min_;
 }
 
+void MapToMinMax::GetValues(const double *x, const double *y, const double *z, int count,
+    float *out) const
+{
+    assert(m_pSourceModule[0] != NULL);
+    noise::batch::GetValues(*m_pSourceModule[0], x, y, z, count, out);
+    MapValues(out, count);
+}
+
+void MapToMinMax::MapValues(float *values, int count) const
+{
+    const float scale = (float)(height_ * 0.5);
+    const float bias = (float)(height_ * 0.5 + min_);
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = values[i] * scale + bias;
+    }
+}
+
 void MapToMinMax::SetMinAndMax(double min, double max)
 {
     assert(max > min);
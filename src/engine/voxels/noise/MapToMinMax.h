@@ -18,6 +18,11 @@ public:
 
     double GetValue(double x, double y, double z) const override;
 
+    // Batch version of GetValue, see noise::batch::GetValues
+    void GetValues(const double *x, const double *y, const double *z, int count, float *out) const;
+    // Map the source module values in place
+    void MapValues(float *values, int count) const;
+
     void SetMinAndMax(double min, double max);
     void SetMinAndHeight(double min, double height);
 